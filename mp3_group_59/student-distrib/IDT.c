@@ -115,7 +115,12 @@ void General_Protection(void){
 
 }
 
-void Page_Fault(void){
+/* Page_Fault is handed the faulting address (CR2) & error code by its own stub in
+ * assembly_linkage.S; writes to shared program pages are resolved and resumed */
+void Page_Fault(uint32_t fault_addr, uint32_t error_code){
+    if(program_page_fault(fault_addr, error_code) == 0){
+        return;
+    }
     printf("Error: %s", "Page_Fault\n");
     // while(1);
     system_halt(255);
@@ -242,6 +247,10 @@ void init_IDT(void){
 
 
     /*Initializing Gate Descriptors for devices*/
+    idt[PIT_IRQ_VECTOR].present = 1;
+    idt[PIT_IRQ_VECTOR].dpl = 0;
+    SET_IDT_ENTRY(idt[PIT_IRQ_VECTOR], pit_handler_link);
+    
     // keyboard
     idt[KEYBOARD_IRQ].present = 1; // set present state high
     idt[KEYBOARD_IRQ].dpl = 0;
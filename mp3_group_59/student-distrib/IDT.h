@@ -19,7 +19,8 @@
 #define SYSCALL         0x80
 #define IRQ_MAPPED      0x20
 #define EXCEPTIONS_NUM  21
-#define KEYBOARD_IRQ    0x21        // IDT table index
+#define PIT_IRQ_VECTOR  0x20        // IDT table index
+#define KEYBOARD_IRQ    0x21
 #define RTC_IRQ         0x28
 
 
@@ -51,7 +52,7 @@ extern void Stack_Segment_Fault(void);
 
 extern void General_Protection(void);
 
-extern void Page_Fault(void);
+extern void Page_Fault(uint32_t fault_addr, uint32_t error_code);
 
 extern void Intel_Reserved(void);
 
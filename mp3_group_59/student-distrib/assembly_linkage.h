@@ -32,7 +32,8 @@
  void Machine_Check_link();
  void SIMD_Floating_Point_Exception_link();
 
-/* keyboard & rtc linkage */
+/* pit, keyboard & rtc linkage */
+ void pit_handler_link();
  void rtc_handler_link();
  void keyboard_handler_link();
  
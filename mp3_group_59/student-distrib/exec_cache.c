@@ -0,0 +1,245 @@
+/* exec_cache.c - Caches validated executable images for system_execute
+ * Functions: exec_cache_init, exec_cache_lookup, exec_cache_load, exec_cache_page_in, exec_cache_get_stats
+ * NOTES:
+ *      - a miss reads only the first page of the file, checks the ELF magic & pulls the
+ *        entry point out of it; the rest of the image is paged in on first touch
+ *      - pool space is handed out bump-style and never freed (the filesystem is read-only)
+ */
+
+#include "exec_cache.h"
+
+/*Magic Bytes for bytes 0-3 in file*/
+#define MAGIC_BYTE_0    0x7f 
+#define MAGIC_BYTE_1    0x45 
+#define MAGIC_BYTE_2    0x4c
+#define MAGIC_BYTE_3    0x46
+
+static exec_cache_entry_t exec_cache[EXEC_CACHE_ENTRIES];
+static exec_cache_entry_t exec_cache_scratch;                   // returned when every slot is taken
+static uint8_t exec_cache_pool[EXEC_CACHE_POOL_SIZE] __attribute__((aligned(BYTES_4KB)));
+static uint32_t exec_cache_pool_next;                           // next free byte in the pool
+static exec_cache_stats_t exec_cache_stats;
+
+/*
+*   FUNCTION: exec_header_check
+*   DESCRIPTION: Validates the ELF magic in a file header and pulls out the entry point
+*   INPUTS: 
+*           const uint8_t* header -- at least EXEC_HEADER_LEN bytes from the start of the file
+*           uint32_t* entry_eip -- filled with bytes 24-27 if the magic matches
+*   OUTPUTS: 1 if executable, 0 if not
+*   SIDE EFFECTS: none
+*/
+static uint32_t exec_header_check(const uint8_t* header, uint32_t* entry_eip){
+    if(header[0] != MAGIC_BYTE_0 || header[1] != MAGIC_BYTE_1 ||
+       header[2] != MAGIC_BYTE_2 || header[3] != MAGIC_BYTE_3){
+        return 0;
+    }
+    *entry_eip = *((uint32_t*)(header + EXEC_ENTRY_OFFSET));
+    return 1;
+}
+
+/*
+*   FUNCTION: exec_cache_read_page
+*   DESCRIPTION: Reads one image page from the file into its pool page & marks it loaded
+*   INPUTS: 
+*           exec_cache_entry_t* entry -- entry with pool space reserved
+*           uint32_t page -- page index within the image
+*   OUTPUTS: 0 for success; -1 for fail
+*   SIDE EFFECTS: fills the pool page (the tail past the end of the file stays zero)
+*/
+static int32_t exec_cache_read_page(exec_cache_entry_t* entry, uint32_t page){
+    uint32_t offset = page * BYTES_4KB;
+    uint32_t length = entry->length - offset;
+
+    if(length > BYTES_4KB){
+        length = BYTES_4KB;
+    }
+    if(read_data(entry->inode, offset, entry->image + offset, length) != length){
+        return -1;
+    }
+    entry->page_loaded[page / BITS_32] |= (1 << (page % BITS_32));
+    exec_cache_stats.pages_read++;
+    return 0;
+}
+
+/*
+*   FUNCTION: exec_cache_fill
+*   DESCRIPTION: Validates a file that missed the cache from its first page. Executables get
+*   pool space for the whole image when there is room; only the first page is read now.
+*   INPUTS: 
+*           exec_cache_entry_t* entry -- slot to fill (inode already set)
+*   OUTPUTS: none
+*   SIDE EFFECTS: may consume pool space
+*/
+static void exec_cache_fill(exec_cache_entry_t* entry){
+    uint8_t header[EXEC_HEADER_LEN];
+    uint32_t length = inodes[entry->inode].length;
+    uint32_t padded_length = (length + BYTES_4KB - 1) & ~(BYTES_4KB - 1);    // keep images page aligned
+    int i;
+
+    entry->length = length;
+    entry->image = NULL;
+    entry->executable = 0;
+    entry->entry_eip = 0;
+    entry->valid = 1;
+    for(i = 0; i < EXEC_PAGE_WORDS; i++){
+        entry->page_loaded[i] = 0;
+    }
+
+    if(length < EXEC_HEADER_LEN){                               // too short to hold an ELF header
+        return;
+    }
+    if(read_data(entry->inode, 0, header, EXEC_HEADER_LEN) != EXEC_HEADER_LEN){
+        return;
+    }
+    entry->executable = exec_header_check(header, &entry->entry_eip);
+    if(!entry->executable){
+        return;
+    }
+
+    /* pool full (or no slot to remember the image in): image is paged in from the file */
+    if(entry == &exec_cache_scratch || padded_length > EXEC_CACHE_POOL_SIZE - exec_cache_pool_next){
+        exec_cache_stats.uncached++;
+        return;
+    }
+
+    /* reserve the pool pages (they are zero) and bring in the page holding the header */
+    entry->image = &exec_cache_pool[exec_cache_pool_next];
+    exec_cache_pool_next += padded_length;
+    exec_cache_stats.pool_used = exec_cache_pool_next;
+    if(exec_cache_read_page(entry, 0) != 0){
+        entry->executable = 0;
+    }
+}
+
+/*
+*   FUNCTION: exec_cache_init
+*   DESCRIPTION: Empties the cache & resets counters. Called after filesystem_initialize.
+*   INPUTS: none
+*   OUTPUTS: none
+*   SIDE EFFECTS: cache cleared
+*/
+void exec_cache_init(void){
+    int i;
+    for(i = 0; i < EXEC_CACHE_ENTRIES; i++){
+        exec_cache[i].valid = 0;
+        exec_cache[i].image = NULL;
+    }
+    exec_cache_pool_next = 0;
+    memset(&exec_cache_stats, 0, sizeof(exec_cache_stats));
+}
+
+/*
+*   FUNCTION: exec_cache_lookup
+*   DESCRIPTION: Finds (or creates) the cache entry for an inode
+*   INPUTS: 
+*           uint32_t inode -- inode of the program file
+*           exec_cache_entry_t** entry -- set to the entry for the file
+*   OUTPUTS: 0 if the file is executable; -1 if not (or bad inode)
+*   SIDE EFFECTS: a miss reads the file & may consume pool space
+*/
+int32_t exec_cache_lookup(uint32_t inode, exec_cache_entry_t** entry){
+    uint64_t start = rdtsc();
+    exec_cache_entry_t* slot = NULL;
+    int i;
+
+    if(entry == NULL || inode >= boot_block->inode_count){
+        return -1;
+    }
+
+    for(i = 0; i < EXEC_CACHE_ENTRIES; i++){
+        if(exec_cache[i].valid && exec_cache[i].inode == inode){
+            exec_cache_stats.hits++;
+            exec_cache_stats.hit_cycles += rdtsc() - start;
+            *entry = &exec_cache[i];
+            return exec_cache[i].executable ? 0 : -1;
+        }
+        if(slot == NULL && !exec_cache[i].valid){
+            slot = &exec_cache[i];
+        }
+    }
+
+    /* miss: every slot taken means the result is not remembered */
+    exec_cache_stats.misses++;
+    if(slot == NULL){
+        slot = &exec_cache_scratch;
+    }
+    slot->inode = inode;
+    exec_cache_fill(slot);
+    exec_cache_stats.miss_cycles += rdtsc() - start;
+
+    *entry = slot;
+    if(!slot->executable){
+        exec_cache_stats.rejects++;
+        return -1;
+    }
+    return 0;
+}
+
+/*
+*   FUNCTION: exec_cache_page_in
+*   DESCRIPTION: Returns the pristine pool copy of one image page, reading it from the file
+*   the first time any process touches it
+*   INPUTS: 
+*           exec_cache_entry_t* entry -- executable entry from exec_cache_lookup
+*           uint32_t page -- page index within the image
+*   OUTPUTS: address of the page in the pool; NULL if the image is not cached or page is out of range
+*   SIDE EFFECTS: may read one page from the filesystem
+*/
+uint8_t* exec_cache_page_in(exec_cache_entry_t* entry, uint32_t page){
+    if(entry == NULL || entry->image == NULL || page * BYTES_4KB >= entry->length){
+        return NULL;
+    }
+    if(!(entry->page_loaded[page / BITS_32] & (1 << (page % BITS_32)))){
+        if(exec_cache_read_page(entry, page) != 0){
+            return NULL;
+        }
+    }
+    return entry->image + (page * BYTES_4KB);
+}
+
+/*
+*   FUNCTION: exec_cache_load
+*   DESCRIPTION: Copies a whole program image to dest: pages in the pool copy first when
+*   the image is cached, otherwise one read_data from the file
+*   INPUTS: 
+*           exec_cache_entry_t* entry -- executable entry from exec_cache_lookup
+*           uint8_t* dest -- where the image goes
+*   OUTPUTS: 0 for success; -1 for fail
+*   SIDE EFFECTS: writes entry->length bytes at dest
+*/
+int32_t exec_cache_load(exec_cache_entry_t* entry, uint8_t* dest){
+    uint32_t page;
+
+    if(entry == NULL || !entry->executable){
+        return -1;
+    }
+    if(entry->image != NULL){
+        for(page = 0; page * BYTES_4KB < entry->length; page++){
+            if(exec_cache_page_in(entry, page) == NULL){
+                return -1;
+            }
+        }
+        memcpy(dest, entry->image, entry->length);
+        return 0;
+    }
+    if(read_data(entry->inode, 0, dest, entry->length) != entry->length){
+        return -1;
+    }
+    return 0;
+}
+
+/*
+*   FUNCTION: exec_cache_get_stats
+*   DESCRIPTION: Copies out the exec cache counters
+*   INPUTS: 
+*           exec_cache_stats_t* stats -- filled with the current counters
+*   OUTPUTS: none
+*   SIDE EFFECTS: none
+*/
+void exec_cache_get_stats(exec_cache_stats_t* stats){
+    if(stats == NULL){
+        return;
+    }
+    *stats = exec_cache_stats;
+}
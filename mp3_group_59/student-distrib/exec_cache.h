@@ -0,0 +1,53 @@
+/* exec_cache.h - Defines & headers for the executable image cache used by system_execute
+ * NOTES:
+ *      - keyed by inode number; the filesystem is read-only so entries never go stale
+ *      - images are kept page aligned & zero padded to a 4KB boundary
+ *      - pool space for an image is reserved on the first launch but each page is only read
+ *        from the file the first time some process touches it (exec_cache_page_in)
+ */
+
+#ifndef _EXEC_CACHE_H
+#define _EXEC_CACHE_H
+
+#include "types.h"
+#include "lib.h"
+#include "filesystem.h"
+
+#define EXEC_CACHE_ENTRIES      16                              // distinct executables remembered
+#define EXEC_CACHE_POOL_SIZE    (BYTES_4KB * 128)               // 512KB of pristine image copies
+#define EXEC_HEADER_LEN         28                              // ELF magic (bytes 0-3) through entry point (bytes 24-27)
+#define EXEC_ENTRY_OFFSET       24                              // byte offset of the entry point in the image
+#define EXEC_CACHE_MAX_PAGES    (EXEC_CACHE_POOL_SIZE / BYTES_4KB)  // pages an image can span in the pool
+#define EXEC_PAGE_WORDS         (EXEC_CACHE_MAX_PAGES / BITS_32)    // words in the per-image page loaded bitmap
+
+/* Exec Cache Entry: one validated (or rejected) file */
+typedef struct exec_cache_entry{
+    uint32_t valid;                                             // 1 if slot in use
+    uint32_t executable;                                        // 1 if ELF magic matched
+    uint32_t inode;
+    uint32_t length;                                            // image length in bytes
+    uint32_t entry_eip;                                         // first user instruction (bytes 24-27)
+    uint8_t* image;                                             // page aligned pristine copy; NULL if pool was full
+    uint32_t page_loaded[EXEC_PAGE_WORDS];                      // bit set once that image page was read from the file
+} exec_cache_entry_t;
+
+/* Exec Cache Counters */
+typedef struct exec_cache_stats{
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t rejects;                                           // lookups of files that are not executables
+    uint32_t uncached;                                          // misses that could not get pool space
+    uint32_t pool_used;                                         // bytes of pool handed out
+    uint32_t pages_read;                                        // image pages read from the filesystem into the pool
+    uint64_t hit_cycles;                                        // total cycles spent in lookups that hit
+    uint64_t miss_cycles;                                       // total cycles spent in lookups that missed
+} exec_cache_stats_t;
+
+/* Functions to Manage the Exec Cache */
+void exec_cache_init(void);
+int32_t exec_cache_lookup(uint32_t inode, exec_cache_entry_t** entry);
+int32_t exec_cache_load(exec_cache_entry_t* entry, uint8_t* dest);
+uint8_t* exec_cache_page_in(exec_cache_entry_t* entry, uint32_t page);
+void exec_cache_get_stats(exec_cache_stats_t* stats);
+
+#endif
@@ -6,7 +6,77 @@
 
 #include "filesystem.h"
 
+#define FNV_OFFSET_BASIS    2166136261U                         // 32-bit FNV-1a constants
+#define FNV_PRIME           16777619U
 
+static name_index_entry_t name_index[NAME_INDEX_SIZE];          // open-addressed table built once at init
+static name_index_stats_t name_index_stats;
+
+/*
+*   FUNCTION: name_hash
+*   DESCRIPTION: 32-bit FNV-1a hash over a file name. Stops at the first NUL or after
+*   BYTES_32B characters, matching the strncmp(.., BYTES_32B) the lookup used before.
+*   INPUTS: 
+*           const int8_t* name -- file name (need not be NUL terminated if 32 chars long)
+*   OUTPUTS: hash of the name
+*   SIDE EFFECTS: none
+*/
+static uint32_t name_hash(const int8_t* name){
+    uint32_t hash = FNV_OFFSET_BASIS;
+    int i;
+    for(i = 0; i < BYTES_32B && name[i] != '\0'; i++){
+        hash ^= (uint8_t)name[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+/*
+*   FUNCTION: name_index_build
+*   DESCRIPTION: Hashes every directory entry in the boot block into name_index
+*   (linear probing). Called once from filesystem_initialize.
+*   INPUTS: none
+*   OUTPUTS: none
+*   SIDE EFFECTS: name_index & counters reset
+*/
+static void name_index_build(void){
+    uint32_t slot;
+    uint32_t hash;
+    int32_t i;
+
+    for(i = 0; i < NAME_INDEX_SIZE; i++){
+        name_index[i].name_hash = 0;
+        name_index[i].dentry_index = NAME_INDEX_EMPTY;
+    }
+    name_index_stats.hits = 0;
+    name_index_stats.misses = 0;
+    name_index_stats.string_compares = 0;
+
+    for(i = 0; i < boot_block->dir_count && i < NUM_MAX_FILES; i++){
+        hash = name_hash(boot_block->direntries[i].file_name);
+        slot = hash & (NAME_INDEX_SIZE - 1);
+        while(name_index[slot].dentry_index != NAME_INDEX_EMPTY){
+            slot = (slot + 1) & (NAME_INDEX_SIZE - 1);
+        }
+        name_index[slot].name_hash = hash;
+        name_index[slot].dentry_index = i;
+    }
+}
+
+/*
+*   FUNCTION: name_index_get_stats
+*   DESCRIPTION: Copies out the name index hit/miss counters
+*   INPUTS: 
+*           name_index_stats_t* stats -- filled with the current counters
+*   OUTPUTS: none
+*   SIDE EFFECTS: none
+*/
+void name_index_get_stats(name_index_stats_t* stats){
+    if(stats == NULL){
+        return;
+    }
+    *stats = name_index_stats;
+}
 
 /*
 *   FUNCTION: filesystem_initialize
@@ -20,6 +90,7 @@ void filesystem_initialize(uint32_t start){
     boot_block = (bootblock_t*)start;                                                     // put boot block at start of filesystem img
     inodes = (inode_t*)(boot_block + 1);                                    // add 1 for boot block
     data_blocks = (datablock_t*)(inodes + boot_block->inode_count);         // set up addr for data blocks
+    name_index_build();                                                     // hash every dentry name once
 
     // printf("Filesystem initialized \n");
 }
@@ -58,7 +129,9 @@ int32_t read_dentry_by_index(uint8_t index, dentry_t* dentry){
 
 /*
 *   FUNCTION: read_dentry_by_name
-*   DESCRIPTION: Scans through directory entries in the boot block to find the file name
+*   DESCRIPTION: Looks the file name up in the name index built by filesystem_initialize.
+*   Slots are only string-compared when their cached 32-bit hash matches, so misses
+*   are rejected without any strncmp.
 *   INPUTS: 
 *           const uint8_t* fname -- name of read dentry
 *           dentry_t* dentry -- buffer to fill with read data
@@ -66,25 +139,39 @@ int32_t read_dentry_by_index(uint8_t index, dentry_t* dentry){
 *   SIDE EFFECTS: file opened
 */
 int32_t read_dentry_by_name(const uint8_t* fname, dentry_t* dentry){
-    // scan directory entries in boot block
-    uint8_t i;
-    int num_indices = boot_block->dir_count; //sizeof(boot_block.direntries);
-    // call read_dentry_by_index() which populates dentry parameter (file name, file type, inode num)
-    for(i=0; i < num_indices; i++){
-        if(!strncmp((char*)fname, ((&((boot_block->direntries)[i]))->file_name), BITS_32)){                        // size of filename is 32
-            read_dentry_by_index(i, dentry);
-            return 0;
-        }
-        else{
-            continue;
+    uint32_t hash;
+    uint32_t slot;
+    int32_t dentry_index;
+
+    if(fname == NULL || dentry == NULL){
+        return -1;
+    }
+
+    hash = name_hash((const int8_t*)fname);
+    slot = hash & (NAME_INDEX_SIZE - 1);
+
+    // probe until an empty slot ends the chain
+    while((dentry_index = name_index[slot].dentry_index) != NAME_INDEX_EMPTY){
+        if(name_index[slot].name_hash == hash){
+            name_index_stats.string_compares++;
+            if(!strncmp((int8_t*)fname, boot_block->direntries[dentry_index].file_name, BITS_32)){  // size of filename is 32
+                name_index_stats.hits++;
+                read_dentry_by_index(dentry_index, dentry);
+                return 0;
+            }
         }
+        slot = (slot + 1) & (NAME_INDEX_SIZE - 1);
     }
+
+    name_index_stats.misses++;
     return -1;
 }
 
 /*
 *   FUNCTION: read_data
-*   DESCRIPTION: Reads/copies data from a file at inode, starting from offset into file, & of size length
+*   DESCRIPTION: Reads/copies data from a file at inode, starting from offset into file, & of size length.
+*   The start and end data blocks are worked out once, then each contiguous run inside a data block
+*   is moved with a single memcpy instead of copying byte by byte.
 *   INPUTS: 
 *           uint32_t inode -- file index
 *           uint32_t offset -- location of read start within file
@@ -94,62 +181,52 @@ int32_t read_dentry_by_name(const uint8_t* fname, dentry_t* dentry){
 *   SIDE EFFECTS: file opened
 */
 int32_t read_data(uint32_t inode, uint32_t offset, uint8_t* buf, uint32_t length){
-    inode_t curr_inode = inodes[inode];
-    uint32_t curr_data_block_array_index;
-    uint32_t curr_data_block_index;
-    //printf("Read Data Reached!\n");
+    inode_t* curr_inode;                    // points into the filesystem image (no 4KB stack copy)
+    uint32_t block_array_index;             // index into curr_inode->data_block_num
+    uint32_t last_block_array_index;        // last data block touched by this read
+    uint32_t offset_within_block;           // where the copy starts inside the current block
+    uint32_t run_length;                    // bytes copied out of the current block
+    uint32_t num_bytes_copied = 0;          // counts the number of bytes copied
+
     // inode range check
-    // if(inode <= -1 || inode > boot_block->inode_count-1){
-    if(inode > boot_block->inode_count-1){ //if the target inode index doesn't exist
+    if(inode >= boot_block->inode_count){ //if the target inode index doesn't exist
         printf("read_data: Inode out of range \n");
         return -1;
     }
+    curr_inode = &inodes[inode];
 
-    if(offset >= curr_inode.length){                                // has the end of the file been reached by offset -> return 0 (check docs)
+    if(offset >= curr_inode->length){                               // has the end of the file been reached by offset -> return 0 (check docs)
         return 0;
     }
-    
-    //if the offset(start) is valid, check if the offset+length(end) is valid
-    // if(offset+length > curr_inode.length){
-    //     printf("read_data: Inode out of range1 \n");
-    //     return -1;
-    // }
-    
-    //uint8_t temp_buf[NUM_MAX_FILES]; //initialize a temp buffer to write bits into
-    
-    uint32_t current_byte_index; //the byte that we are currently copying
-    uint8_t current_byte; //holds current byte to be written into buffer
-    uint32_t num_bytes_copied = 0; //counts the number of bytes copied
-    uint32_t current_byte_index_within_block; // finds the current index of a byte within a data block
-    int i = 0;
-    //write each individual byte into temp buffer
-    for(current_byte_index = offset; current_byte_index < (offset + length); current_byte_index++){
-        
-        if(current_byte_index == curr_inode.length){
-            //printf("current byte index = %d, file length = %d\n", current_byte_index, curr_inode.length);
-            return current_byte_index - offset;
+
+    /* clamp the read to the end of the file */
+    if(length > curr_inode->length - offset){
+        length = curr_inode->length - offset;
+    }
+    if(length == 0){
+        return 0;
+    }
+
+    /* work out the start and end blocks once */
+    block_array_index = offset / BYTES_4KB;
+    last_block_array_index = (offset + length - 1) / BYTES_4KB;
+    offset_within_block = offset % BYTES_4KB;
+
+    /* copy one contiguous run per data block */
+    for(; block_array_index <= last_block_array_index; block_array_index++){
+        run_length = BYTES_4KB - offset_within_block;
+        if(run_length > length - num_bytes_copied){
+            run_length = length - num_bytes_copied;
         }
 
-        //printf("%d \n", current_byte_index);
-        curr_data_block_array_index = current_byte_index / BYTES_4KB; //find the current data block index for array
-
-        curr_data_block_index = inodes[inode].data_block_num[curr_data_block_array_index]; //find the current data block index within filesystem
-
-        current_byte_index_within_block = current_byte_index % BYTES_4KB;
-        //printf("%d \n", current_byte_index_within_block);
-        current_byte = data_blocks[curr_data_block_index].data[current_byte_index_within_block];
-        //printf("%d \n", current_byte);
-        //putc(current_byte);
-        //putc("\n");
-        
-        //adds current byte to temp buffer
-        //temp_buf[num_bytes_copied] = current_byte;
-        buf[i] = current_byte;
-        i++;
-        num_bytes_copied++;
+        memcpy(buf + num_bytes_copied,
+               &data_blocks[curr_inode->data_block_num[block_array_index]].data[offset_within_block],
+               run_length);
+
+        num_bytes_copied += run_length;
+        offset_within_block = 0;                                    // every block after the first starts at its beginning
     }
 
-    //memcpy(buf, temp_buf, length);
     return num_bytes_copied;
 }
 
@@ -168,9 +245,9 @@ int32_t directory_read(int32_t file_index, void* buff, int32_t num_bytes){
     //printf("directory_read: file index: %d \n", file_index);
     // clear buff?
     dentry_t dentry;
-    //uint32_t inode_index = pcb_obj->fda[file_index].inode_idx;
+    //uint32_t inode_index = pcb_obj->fda[file_index]->inode_idx;
     //int32_t file_size = inodes[inode_index].length;
-    if(read_dentry_by_index(pcb_obj->fda[file_index].file_position, &dentry) == -1){
+    if(read_dentry_by_index(pcb_obj->fda[file_index]->file_position, &dentry) == -1){
         //printf("Error in line 173! \n");
         return -1;
     }
@@ -182,7 +259,7 @@ int32_t directory_read(int32_t file_index, void* buff, int32_t num_bytes){
         //printf("Strncpy error!\n");
         return -1;
     }
-    pcb_obj->fda[file_index].file_position = pcb_obj->fda[file_index].file_position + 1;
+    pcb_obj->fda[file_index]->file_position = pcb_obj->fda[file_index]->file_position + 1;
     //printf("reached \n");
     int strlen_ret = strlen((int8_t*)buff);
     // printf("strlen buff =  %d\n", strlen_ret);
@@ -248,6 +325,9 @@ int32_t no_operation_open(const uint8_t* fname){
 int32_t no_operation_close(int32_t file_index){
     return -1;
 }
+int32_t no_operation_ioctl(int32_t file_index, int32_t cmd, void* arg){
+    return -1;
+}
 
 /*Function: file_read( int32_t file_index, void* buff, int32_t num_bytes)
  *Description: reads data from a file into a buffer
@@ -263,11 +343,11 @@ int32_t file_read(int32_t file_index, void* buff, int32_t num_bytes){
         printf("file_read: Number of bytes is out of range \n");
         return -1;}
     
-    num_bytes_read = read_data(pcb_obj->fda[file_index].inode_idx, pcb_obj->fda[file_index].file_position, buff, num_bytes);         // pass appropriate file data from file found from file_index into file descriptor array (inode, offset, buf, length)
+    num_bytes_read = read_data(pcb_obj->fda[file_index]->inode_idx, pcb_obj->fda[file_index]->file_position, buff, num_bytes);         // pass appropriate file data from file found from file_index into file descriptor array (inode, offset, buf, length)
     if(num_bytes_read == -1){
         return -1;
     }
-    pcb_obj->fda[file_index].file_position += num_bytes_read; //update file position
+    pcb_obj->fda[file_index]->file_position += num_bytes_read; //update file position
     return num_bytes_read;
 }
 
@@ -22,6 +22,8 @@
 #define NUM_MAX_FILES       63                                  // 62 in reality because first is reserved for boot block
 #define NUM_FILES           62 
 #define MAX_OPEN_FILES      8                                  // max number of files that can be open at a time for a process
+#define NAME_INDEX_SIZE     128                                 // slots in the dentry name index (power of 2, > 2 * NUM_MAX_FILES)
+#define NAME_INDEX_EMPTY    -1                                  // marks an unused slot in the name index
 
 /* Directory Entry Struct: stores path for file object */
 typedef struct dentry{
@@ -52,6 +54,20 @@ typedef struct datablock_t{
 } datablock_t;                                                 // 4KB per block
 
 
+/* Name Index Slot: cached hash of a dentry name & where that dentry lives in the boot block */
+typedef struct name_index_entry{
+    uint32_t name_hash;
+    int32_t dentry_index;                                       // NAME_INDEX_EMPTY if slot unused
+} name_index_entry_t;
+
+/* Name Index Counters: lookups answered by read_dentry_by_name */
+typedef struct name_index_stats{
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t string_compares;                                   // strncmp calls made (only on a full hash match)
+} name_index_stats_t;
+
+
 /* File Descriptor/Operations/PCB Structs*/
 
 typedef struct file_operations_table{
@@ -59,6 +75,7 @@ typedef struct file_operations_table{
     int32_t (*write)(int32_t file_index, const void* buf, int32_t nbytes);
     int32_t (*open)(const uint8_t* file_name);
     int32_t (*close)(int32_t file_index);
+    int32_t (*ioctl)(int32_t file_index, int32_t cmd, void* arg);
 }file_operations_table_t;
 
 typedef struct file_descriptor{
@@ -67,21 +84,33 @@ typedef struct file_descriptor{
     uint32_t file_position;         // where user is reading in file
     uint32_t flags;                 // if file is open or closed
     uint32_t file_type;
+    struct rtc_timer* rtc_timer;    // rtc: this open's virtual timer (rtc.c), NULL otherwise
+    struct kstats_snapshot* stats_snapshot;   // stats/irqstats: this open's text (kstats.c), NULL otherwise
 }file_descriptor_t;               // file descriptor
 
 typedef struct pcb{
     uint32_t active; //1 if active, 0 if not
     int32_t pcb_pid;
     int32_t parent_pid;
-    file_descriptor_t fda[MAX_OPEN_FILES];       // array that holds all open files; first two indices are reserved stdin & stdout
+    file_descriptor_t* fda[MAX_OPEN_FILES];      // open files (from fd_cache, NULL if closed); first two indices are reserved stdin & stdout
     uint32_t eip_val;
     uint32_t esp_val;
     uint32_t ebp_val;
     uint32_t tss_esp0;
+    uint32_t sched_esp;         // kernel stack parked by the scheduler (ebp & callee-saved registers on it)
+    int32_t terminal_id;        // terminal the process runs on
+    uint32_t vidmap;            // 1 once it has mapped its terminal's text page (system_vidmap)
+    uint32_t blocked;           // 1 while asleep on a wait queue (skipped by the scheduler)
+    struct pcb* wait_next;      // next sleeper on the same wait queue
     uint8_t args[BYTES_32B];
 
 }pcb_t; //process control block
 
+/* processes asleep until an interrupt handler wakes them (see sched_sleep) */
+typedef struct wait_queue{
+    pcb_t* head;
+}wait_queue_t;
+
 /* Global Pointers to Start of Filesystem Objects */
 inode_t* inodes;
 bootblock_t* boot_block;
@@ -94,6 +123,7 @@ void filesystem_initialize(uint32_t start);
 int32_t read_dentry_by_name(const uint8_t* fname, dentry_t* dentry);
 int32_t read_dentry_by_index(uint8_t index, dentry_t* dentry);
 int32_t read_data(uint32_t inode, uint32_t offset, uint8_t* buf, uint32_t length);
+void name_index_get_stats(name_index_stats_t* stats);
 
 /* Functions to Manage Processes/Open Files/Directories */
 int32_t directory_read(int32_t file_index, void* buff, int32_t num_bytes);
@@ -106,6 +136,7 @@ int32_t no_operation_read(int32_t file_index, void* buff, int32_t num_bytes);
 int32_t no_operation_write(int32_t file_index, const void* buf, int32_t num_bytes);
 int32_t no_operation_open(const uint8_t* fname);
 int32_t no_operation_close(int32_t file_index);
+int32_t no_operation_ioctl(int32_t file_index, int32_t cmd, void* arg);
 
 /* Functions to Manage File Operations */
 int32_t file_read(int32_t file_index, void* buff, int32_t num_bytes);
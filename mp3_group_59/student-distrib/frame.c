@@ -0,0 +1,349 @@
+/* frame.c - Physical frame allocator for kernel stacks, page tables & user pages
+ * Functions: frame_init, frame_alloc, frame_alloc_contig, frame_alloc_large, frame_free,
+ *            frame_free_contig, frame_free_large, frame_get_stats
+ * NOTES:
+ *      - a set bit in frame_bitmap means the frame is in use (or is not RAM)
+ *      - runs are aligned to their size, so a run of up to 32 frames sits inside one
+ *        bitmap word and a 4MB frame is 32 whole words
+ *      - frame_hint is the lowest word that may have a free frame; scans start there
+ *        and skip full words 32 frames at a time
+ */
+
+#include "frame.h"
+
+#define CHECK_FLAG(flags, bit)  ((flags) & (1 << (bit)))
+#define MBI_FLAG_MODS           3
+#define MBI_FLAG_MMAP           6
+#define MMAP_TYPE_RAM           1
+#define MEM_UPPER_START         0x100000                        // mem_upper counts KB from 1MB
+#define WORD_FULL               0xFFFFFFFF
+#define LARGE_WORDS             (FRAME_LARGE_COUNT / 32)        // bitmap words per 4MB frame
+
+static uint32_t frame_bitmap[FRAME_BITMAP_WORDS];
+static uint32_t frame_hint;                                     // no free frame below this bitmap word
+static frame_stats_t frame_stats;
+
+/*
+*   FUNCTION: frame_addr / frame_index
+*   DESCRIPTION: convert between a frame's bitmap index and its physical address
+*/
+static uint32_t frame_addr(uint32_t index){
+    return FRAME_POOL_START + index * FRAME_SIZE;
+}
+
+static uint32_t frame_index(uint32_t addr){
+    return (addr - FRAME_POOL_START) / FRAME_SIZE;
+}
+
+/*
+*   FUNCTION: run_mask
+*   DESCRIPTION: bits of an aligned run of fewer than 32 frames inside its bitmap word
+*   INPUTS: uint32_t index -- first frame, uint32_t count -- frames in the run
+*   OUTPUTS: the mask
+*/
+static uint32_t run_mask(uint32_t index, uint32_t count){
+    return ((1U << count) - 1) << (index % 32);
+}
+
+/*
+*   FUNCTION: frame_mark_range
+*   DESCRIPTION: set the frames overlapping [start, end) free or in use, clamped to the pool
+*   INPUTS: uint32_t start, end -- physical byte range, uint32_t used -- 1 to reserve, 0 to free
+*   OUTPUTS: none
+*   SIDE EFFECTS: only used while building the pool; does not touch the counters
+*/
+static void frame_mark_range(uint32_t start, uint32_t end, uint32_t used){
+    uint32_t index;
+
+    if(start < FRAME_POOL_START){
+        start = FRAME_POOL_START;
+    }
+    if(end > FRAME_POOL_END){
+        end = FRAME_POOL_END;
+    }
+    if(used){
+        start &= ~(FRAME_SIZE - 1);                             // any overlap reserves the frame
+        end = (end + FRAME_SIZE - 1) & ~(FRAME_SIZE - 1);
+    }
+    else{
+        start = (start + FRAME_SIZE - 1) & ~(FRAME_SIZE - 1);   // only whole frames are RAM
+        end &= ~(FRAME_SIZE - 1);
+    }
+    for(; start < end; start += FRAME_SIZE){
+        index = frame_index(start);
+        if(used){
+            frame_bitmap[index / 32] |= (1U << (index % 32));
+        }
+        else{
+            frame_bitmap[index / 32] &= ~(1U << (index % 32));
+        }
+    }
+}
+
+/*
+*   FUNCTION: frame_init
+*   DESCRIPTION: Builds the pool from the multiboot memory map. Falls back to mem_upper
+*                when there is no map, and to the whole pool when there is no mbi.
+*   INPUTS: multiboot_info_t* mbi -- boot information from entry() (may be NULL)
+*   OUTPUTS: none
+*   SIDE EFFECTS: clears the counters
+*/
+void frame_init(multiboot_info_t* mbi){
+    memory_map_t* mmap;
+    module_t* mod;
+    uint32_t i;
+
+    memset(frame_bitmap, 0xFF, sizeof(frame_bitmap));
+    memset(&frame_stats, 0, sizeof(frame_stats));
+    frame_hint = 0;
+
+    if(mbi == NULL){
+        frame_mark_range(FRAME_POOL_START, FRAME_POOL_END, 0);
+    }
+    else if(CHECK_FLAG(mbi->flags, MBI_FLAG_MMAP)){
+        for(mmap = (memory_map_t*)mbi->mmap_addr;
+                (uint32_t)mmap < mbi->mmap_addr + mbi->mmap_length;
+                mmap = (memory_map_t*)((uint32_t)mmap + mmap->size + sizeof(mmap->size))){
+            if(mmap->type != MMAP_TYPE_RAM || mmap->base_addr_high != 0){
+                continue;
+            }
+            if(mmap->length_high != 0 || mmap->base_addr_low + mmap->length_low < mmap->base_addr_low){
+                frame_mark_range(mmap->base_addr_low, FRAME_POOL_END, 0);   // runs past 4GB
+            }
+            else{
+                frame_mark_range(mmap->base_addr_low, mmap->base_addr_low + mmap->length_low, 0);
+            }
+        }
+    }
+    else if(mbi->mem_upper >= FRAME_POOL_END / 1024){
+        frame_mark_range(MEM_UPPER_START, FRAME_POOL_END, 0);
+    }
+    else{
+        frame_mark_range(MEM_UPPER_START, MEM_UPPER_START + mbi->mem_upper * 1024, 0);
+    }
+
+    if(mbi != NULL && CHECK_FLAG(mbi->flags, MBI_FLAG_MODS)){
+        mod = (module_t*)mbi->mods_addr;
+        for(i = 0; i < mbi->mods_count; i++, mod++){
+            frame_mark_range(mod->mod_start, mod->mod_end, 1);
+        }
+    }
+
+    for(i = 0; i < FRAME_COUNT; i++){
+        if(!(frame_bitmap[i / 32] & (1U << (i % 32)))){
+            frame_stats.total_frames++;
+        }
+    }
+    frame_stats.free_frames = frame_stats.total_frames;
+}
+
+/*
+*   FUNCTION: frame_alloc
+*   DESCRIPTION: Hands out the lowest free 4KB frame
+*   INPUTS: none
+*   OUTPUTS: physical address of the frame, FRAME_NONE if the pool is empty
+*   SIDE EFFECTS: the frame's contents are not cleared
+*/
+uint32_t frame_alloc(void){
+    uint32_t word, bit;
+
+    for(word = frame_hint; word < FRAME_BITMAP_WORDS; word++){
+        if(frame_bitmap[word] != WORD_FULL){
+            break;
+        }
+    }
+    frame_hint = word;
+    if(word == FRAME_BITMAP_WORDS){
+        frame_stats.failures++;
+        return FRAME_NONE;
+    }
+
+    for(bit = 0; frame_bitmap[word] & (1U << bit); bit++);
+    frame_bitmap[word] |= (1U << bit);
+    frame_stats.allocations++;
+    frame_stats.free_frames--;
+    return frame_addr(word * 32 + bit);
+}
+
+/*
+*   FUNCTION: frame_alloc_contig
+*   DESCRIPTION: Hands out count physically contiguous frames, aligned to count frames
+*   INPUTS: uint32_t count -- number of frames (a power of two, at most FRAME_LARGE_COUNT)
+*   OUTPUTS: physical address of the first frame, FRAME_NONE if no aligned run is free
+*   SIDE EFFECTS: the frames' contents are not cleared
+*/
+uint32_t frame_alloc_contig(uint32_t count){
+    uint32_t word, index, mask, words, i;
+
+    if(count == 0 || count > FRAME_LARGE_COUNT || (count & (count - 1)) != 0){
+        frame_stats.failures++;
+        return FRAME_NONE;
+    }
+    if(count == 1){
+        return frame_alloc();
+    }
+
+    if(count < 32){
+        for(word = frame_hint; word < FRAME_BITMAP_WORDS; word++){
+            if(frame_bitmap[word] == WORD_FULL){
+                continue;
+            }
+            for(index = word * 32; index < (word + 1) * 32; index += count){
+                mask = run_mask(index, count);
+                if(!(frame_bitmap[word] & mask)){
+                    frame_bitmap[word] |= mask;
+                    frame_stats.allocations += count;
+                    frame_stats.free_frames -= count;
+                    return frame_addr(index);
+                }
+            }
+        }
+    }
+    else{
+        words = count / 32;
+        for(word = frame_hint - (frame_hint % words); word + words <= FRAME_BITMAP_WORDS; word += words){
+            for(i = 0; i < words && frame_bitmap[word + i] == 0; i++);
+            if(i == words){
+                memset(&frame_bitmap[word], 0xFF, words * sizeof(uint32_t));
+                frame_stats.allocations += count;
+                frame_stats.free_frames -= count;
+                return frame_addr(word * 32);
+            }
+        }
+    }
+    frame_stats.failures++;
+    return FRAME_NONE;
+}
+
+/*
+*   FUNCTION: frame_alloc_large
+*   DESCRIPTION: Hands out one 4MB aligned 4MB frame
+*   INPUTS: none
+*   OUTPUTS: physical address, FRAME_NONE if no whole 4MB block is free
+*/
+uint32_t frame_alloc_large(void){
+    return frame_alloc_contig(FRAME_LARGE_COUNT);
+}
+
+/*
+*   FUNCTION: frame_free
+*   DESCRIPTION: Gives one frame back to the pool
+*   INPUTS: uint32_t addr -- physical address returned by frame_alloc
+*   OUTPUTS: none
+*   SIDE EFFECTS: ignores addresses outside the pool and frames that are already free
+*/
+void frame_free(uint32_t addr){
+    uint32_t index;
+
+    if(addr < FRAME_POOL_START || addr >= FRAME_POOL_END || (addr & (FRAME_SIZE - 1)) != 0){
+        return;
+    }
+    index = frame_index(addr);
+    if(!(frame_bitmap[index / 32] & (1U << (index % 32)))){
+        return;
+    }
+    frame_bitmap[index / 32] &= ~(1U << (index % 32));
+    if(index / 32 < frame_hint){
+        frame_hint = index / 32;
+    }
+    frame_stats.frees++;
+    frame_stats.free_frames++;
+}
+
+/*
+*   FUNCTION: frame_free_contig
+*   DESCRIPTION: Gives a run from frame_alloc_contig back to the pool
+*   INPUTS: uint32_t addr -- first frame, uint32_t count -- frames in the run
+*   OUTPUTS: none
+*   SIDE EFFECTS: whole words are cleared at once when the run covers them
+*/
+void frame_free_contig(uint32_t addr, uint32_t count){
+    uint32_t index, word;
+
+    if(count < 32 || addr < FRAME_POOL_START || addr + count * FRAME_SIZE > FRAME_POOL_END ||
+            (addr & (count * FRAME_SIZE - 1)) != 0 || (count & (count - 1)) != 0){
+        for(index = 0; index < count; index++){                 // small or odd runs: one frame at a time
+            frame_free(addr + index * FRAME_SIZE);
+        }
+        return;
+    }
+
+    index = frame_index(addr);
+    for(word = index / 32; word < (index + count) / 32; word++){
+        if(frame_bitmap[word] != WORD_FULL){                    // not a run we handed out
+            for(index = 0; index < count; index++){
+                frame_free(addr + index * FRAME_SIZE);
+            }
+            return;
+        }
+    }
+    memset(&frame_bitmap[index / 32], 0, (count / 32) * sizeof(uint32_t));
+    if(index / 32 < frame_hint){
+        frame_hint = index / 32;
+    }
+    frame_stats.frees += count;
+    frame_stats.free_frames += count;
+}
+
+/*
+*   FUNCTION: frame_free_large
+*   DESCRIPTION: Gives a 4MB frame from frame_alloc_large back to the pool
+*   INPUTS: uint32_t addr -- physical address of the 4MB frame
+*   OUTPUTS: none
+*/
+void frame_free_large(uint32_t addr){
+    frame_free_contig(addr, FRAME_LARGE_COUNT);
+}
+
+/*
+*   FUNCTION: frame_get_stats
+*   DESCRIPTION: copy out the allocator counters and measure fragmentation
+*   INPUTS: frame_stats_t* stats -- filled with the current counters
+*   OUTPUTS: none
+*   SIDE EFFECTS: walks the whole bitmap
+*/
+void frame_get_stats(frame_stats_t* stats){
+    uint32_t word, bit, run, free_words;
+
+    if(stats == NULL){
+        return;
+    }
+    frame_stats.free_large = 0;
+    frame_stats.largest_free_run = 0;
+    run = 0;
+    free_words = 0;
+    for(word = 0; word < FRAME_BITMAP_WORDS; word++){
+        if(frame_bitmap[word] == 0){                            // whole word free
+            run += 32;
+            if(++free_words == LARGE_WORDS){
+                frame_stats.free_large++;
+                free_words = 0;
+            }
+        }
+        else{
+            free_words = 0;
+            for(bit = 0; bit < 32; bit++){
+                if(frame_bitmap[word] & (1U << bit)){
+                    run = 0;
+                }
+                else{
+                    run++;
+                }
+                if(run > frame_stats.largest_free_run){
+                    frame_stats.largest_free_run = run;
+                }
+            }
+        }
+        if((word + 1) % LARGE_WORDS == 0){
+            free_words = 0;                                     // 4MB blocks stay aligned
+        }
+        if(run > frame_stats.largest_free_run){
+            frame_stats.largest_free_run = run;
+        }
+    }
+    frame_stats.fragmentation = 0;
+    if(frame_stats.free_frames != 0){
+        frame_stats.fragmentation = 100 - (frame_stats.largest_free_run * 100) / frame_stats.free_frames;
+    }
+    *stats = frame_stats;
+}
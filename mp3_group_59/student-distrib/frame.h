@@ -0,0 +1,48 @@
+/* frame.h - Defines & headers for the physical frame allocator
+ * NOTES:
+ *      - manages 4KB frames between 8MB and 128MB, which paging_init identity maps
+ *        (supervisor only) so the kernel can reach any frame it owns
+ *      - only frames the multiboot memory map reports as usable RAM are handed out;
+ *        boot modules (the filesystem image) are kept out of the pool
+ *      - one bit per frame; runs (kernel stacks, 4MB pages) are aligned to their size
+ */
+
+#ifndef _FRAME_H
+#define _FRAME_H
+
+#include "types.h"
+#include "lib.h"
+#include "multiboot.h"
+
+#define FRAME_SIZE              0x1000                          // 4KB
+#define FRAME_LARGE_SIZE        0x400000                        // 4MB
+#define FRAME_LARGE_COUNT       (FRAME_LARGE_SIZE / FRAME_SIZE) // 4KB frames in a 4MB frame
+#define FRAME_POOL_START        0x800000                        // 8MB, right after the kernel page
+#define FRAME_POOL_END          0x8000000                       // 128MB, end of the identity mapped region
+#define FRAME_COUNT             ((FRAME_POOL_END - FRAME_POOL_START) / FRAME_SIZE)
+#define FRAME_BITMAP_WORDS      (FRAME_COUNT / 32)
+#define FRAME_NONE              0                               // returned when the pool is exhausted
+
+/* Frame Allocator Counters */
+typedef struct frame_stats{
+    uint32_t total_frames;                                      // usable frames found at boot
+    uint32_t free_frames;
+    uint32_t allocations;                                       // frames handed out
+    uint32_t frees;                                             // frames given back
+    uint32_t failures;                                          // requests that could not be met
+    uint32_t free_large;                                        // free, aligned 4MB frames
+    uint32_t largest_free_run;                                  // longest run of free 4KB frames
+    uint32_t fragmentation;                                     // % of free memory outside the largest run
+} frame_stats_t;
+
+/* Functions to Manage Physical Frames */
+void frame_init(multiboot_info_t* mbi);
+uint32_t frame_alloc(void);
+uint32_t frame_alloc_contig(uint32_t count);
+uint32_t frame_alloc_large(void);
+void frame_free(uint32_t addr);
+void frame_free_contig(uint32_t addr, uint32_t count);
+void frame_free_large(uint32_t addr);
+void frame_get_stats(frame_stats_t* stats);
+
+#endif /* _FRAME_H */
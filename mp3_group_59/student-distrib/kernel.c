@@ -10,6 +10,9 @@
 #include "tests.h"
 #include "paging.h"
 #include "rtc.h"
+#include "exec_cache.h"
+#include "slab.h"
+#include "scheduler.h"
 
 #define RUN_TESTS
 
@@ -24,6 +27,7 @@ uint32_t filesystem_img_addr = 0;
 void entry(unsigned long magic, unsigned long addr) {
 
     multiboot_info_t *mbi;
+    int32_t fast_syscalls;
 
 
     /* Clear the screen. */
@@ -143,6 +147,8 @@ void entry(unsigned long magic, unsigned long addr) {
     }
     /* Init the Interrupt Descriptor Table */
     init_IDT();
+    /* Fast system call entry (int $0x80 stays for older programs & CPUs without it) */
+    fast_syscalls = sysenter_init();
     /* Init the PIC */
     i8259_init();
     /* Init the Devices */
@@ -150,14 +156,21 @@ void entry(unsigned long magic, unsigned long addr) {
     keyboard_initialize();
     /* Init the Filesystem & Paging */
     filesystem_initialize(filesystem_img_addr);
+    exec_cache_init();
     file_operations_initialize();
+    pid_allocator_init();
     
     //file_operations_initialize();
+    frame_init(mbi);
+    slab_init();
     paging_init();
 
     clear();
     set_cursor(0,0);
     terminal_videopage_init();
+    if(fast_syscalls != 0){
+        printf("No SYSENTER on this CPU, programs fall back to int $0x80\n");
+    }
     //terminal_init(0);           // initialize to first terminal
     //system_execute((uint8_t*)"shell");
 
@@ -180,6 +193,8 @@ void entry(unsigned long magic, unsigned long addr) {
     launch_tests();
 #endif
     /* Execute the first program ("shell") ... */
+    /* the scheduler launches it (& the other terminals' shells) from the PIT */
+    sched_init();
 
     /* Spin (nicely, so we don't chew up cycles) */
     asm volatile (".1: hlt; jmp .1;");
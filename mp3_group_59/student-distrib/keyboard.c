@@ -4,6 +4,7 @@
  */
 
 #include "keyboard.h"
+#include "scheduler.h"
 
 //int kb_buff_len = 0;                  // length of keyboard buffer (different to num_chars_typed b/c of tab)
 int ctrl_pressed = 0;                   // bool flag to see if ctrl key was pressed so code can look out for next character
@@ -13,8 +14,6 @@ int alt_pressed = 0;                    // bool flag to see if alt key was press
 //int switch_terminals = 0;               // bool flag to see if alt key was pressed so code can look out for next character
 //bool key_pressed = false;             // uncomment for paging test
 
-/* global buffer that holds character history from keyboard */
-uint8_t keyboard_buffer[NUM_CHARS_KB];
 /* look up table to convert output from keyboard to readable ascii's */
 uint8_t ascii_lookup_table[SIZE_KB_CODES]= {                                            // scan codes from keyboard map to certain ascii's according to osdev; keycodes are index for tables; 
   0x00, 0x00, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x30, 
@@ -38,20 +37,105 @@ uint8_t ascii_caps_lookup_table[SIZE_KB_CODES]= {
 
 
 /*
-  * clear_keyboard_buff
-  * DESCRIPTION: clears keyboard buffer
-  * INPUTS: none
+  * kb_ring_init
+  * DESCRIPTION: empties a terminal's keyboard ring
+  * INPUTS: ring
   * OUTPUS: none
   * RETURN VALUE: none
   * 
   */
-void clear_keyboard_buff(void){
-  int i;
+void kb_ring_init(kb_ring_t* ring){
+  ring->head = 0;
+  ring->commit = 0;
+  ring->tail = 0;
+}
+
+/*
+  * kb_ring_put
+  * DESCRIPTION: producer: appends a character to the line being typed. A line holds
+  *              at most NUM_CHARS_KB - 1 characters and one slot is always kept
+  *              for the '\n' kb_ring_commit adds.
+  * INPUTS: ring, c
+  * OUTPUS: none
+  * RETURN VALUE: 0 if stored (echo it), -1 if the line or the ring is full
+  * 
+  */
+int32_t kb_ring_put(kb_ring_t* ring, uint8_t c){
+  uint32_t head = ring->head;
+
+  if(head - ring->commit >= NUM_CHARS_KB - 1 || head - ring->tail >= KB_RING_SIZE - 1){
+    return -1;
+  }
+  ring->data[head & KB_RING_MASK] = c;
+  ring->head = head + 1;
+  return 0;
+}
+
+/*
+  * kb_ring_unput
+  * DESCRIPTION: producer: backspace, drops the last character of the line being typed
+  * INPUTS: ring
+  * OUTPUS: none
+  * RETURN VALUE: 0 if a character was dropped (erase it), -1 if the line is empty
+  * 
+  */
+int32_t kb_ring_unput(kb_ring_t* ring){
+  if(ring->head == ring->commit){
+    return -1;
+  }
+  ring->head--;
+  return 0;
+}
+
+/*
+  * kb_ring_commit
+  * DESCRIPTION: producer: ends the line being typed with '\n' and hands it to the
+  *              reader; the data is written before commit moves past it
+  * INPUTS: ring
+  * OUTPUS: none
+  * RETURN VALUE: 0 if the line was committed, -1 if the ring is full (lines nobody
+  *               has read yet fill it, the typed line stays pending)
+  * 
+  */
+int32_t kb_ring_commit(kb_ring_t* ring){
+  uint32_t head = ring->head;
+
+  if(head - ring->tail >= KB_RING_SIZE){
+    return -1;
+  }
+  ring->data[head & KB_RING_MASK] = '\n';
+  ring->head = head + 1;
+  asm volatile("" : : : "memory");                              // line is in the ring before it is published
+  ring->commit = head + 1;
+  return 0;
+}
 
-  for(i = 0; i < NUM_CHARS_KB; i++){
-    keyboard_buffer[i] = 0;
+/*
+  * kb_ring_get
+  * DESCRIPTION: consumer: copies out finished input up to and including the next '\n'
+  *              (or nbytes); whatever is left stays queued for the next read
+  * INPUTS: ring, buf, nbytes
+  * OUTPUS: none
+  * RETURN VALUE: number of bytes copied, 0 if no line is finished
+  * 
+  */
+int32_t kb_ring_get(kb_ring_t* ring, uint8_t* buf, int32_t nbytes){
+  uint32_t tail = ring->tail;
+  uint32_t commit = ring->commit;
+  int32_t n = 0;
+  uint8_t c;
+
+  while(n < nbytes && tail != commit){
+    c = ring->data[tail & KB_RING_MASK];
+    tail++;
+    buf[n++] = c;
+    if(c == '\n'){
+      break;
+    }
   }
-  num_chars_typed = 0;
+  asm volatile("" : : : "memory");                              // done reading before the slots are given back
+  ring->tail = tail;
+  return n;
 }
 
 /*
@@ -93,9 +177,10 @@ void print_to_screen(uint8_t key_code, uint8_t key_char){
         key_char = ascii_lookup_table[key_code];
       }
       
-      keyboard_buffer[num_chars_typed] = key_char;
-      num_chars_typed++;
-      putc(key_char);                                               // outputs char to screen
+      scrollback_reset(&terminals[curr_terminal_id].scrollback, terminals[curr_terminal_id].video_mem_addr);  // typing jumps back to the live screen
+      if(kb_ring_put(&terminals[curr_terminal_id].input, key_char) == 0){
+        putc(key_char);                                             // outputs char to screen
+      }
 
     /* debug tests */
     //printf("%d", num_chars_typed);
@@ -113,10 +198,12 @@ void print_to_screen(uint8_t key_code, uint8_t key_char){
   * 
   */
 void keyboard_initialize(void){
+  int i;
+
 	enable_irq(KEYBOARD_IRQ_NUM);										                  // 1 bc that's the IRQ number on IDT
-  num_chars_typed = 0;
-  clear_keyboard_buff();
-  enter_pressed_flag = 0;
+  for(i = 0; i < NUM_TERMINALS; i++){
+    kb_ring_init(&terminals[i].input);
+  }
 }
 
  /*
@@ -135,17 +222,22 @@ void keyboard_handler(void) {
   uint8_t key_code;                   // output from the keyboard
   //int num_spaces;                     // loop counter for tab
   uint32_t screen_x, screen_y;
-  int i;
+  uint32_t i;
+  kb_ring_t* ring = &terminals[curr_terminal_id].input;   // input goes to the terminal on screen
+  int32_t prev_console = -1;
   //key_pressed = true;
 
   cli();                                  // clear interrupt
 
+  if(terminals[curr_terminal_id].active){
+    prev_console = console_select(curr_terminal_id);      // echo on screen, whichever terminal was interrupted
+  }
+
   key_code = inb(KEYBOARD_DATA_PORT);			// reads from kb data port (char is one byte but inb returns 32)
 
   switch (key_code){
     case BACKSPACE_KEYCODE :
-      if(num_chars_typed > 0){
-        num_chars_typed = num_chars_typed - 1;
+      if(kb_ring_unput(ring) == 0){
 
         screen_x = get_screen_x() - 1;
         screen_y = get_screen_y();
@@ -162,8 +254,7 @@ void keyboard_handler(void) {
       // for(num_spaces = 0; num_spaces <= 4; num_spaces++){     // four spaces for tab
       //   putc(SPACE_KEY);
       // }
-      num_chars_typed++;             // = num_chars_typed + 4; for tab case (not necessary)
-      keyboard_buffer[num_chars_typed] = '\t';
+      kb_ring_put(ring, '\t');
       break;
     case CTRL_KEYCODE :
       ctrl_pressed = 1;
@@ -175,15 +266,8 @@ void keyboard_handler(void) {
       if(ctrl_pressed == 1){
         clear();                                              // clear screen
         set_cursor(0, 0);                                     // put cursor at top of screen
-        for(i = 0; i <= num_chars_typed; i++){                 // display what was last in keyboard buff
-          putc(keyboard_buffer[i]);
-        }
-
-        if(num_chars_typed > MAX_CHARS_LINE){                 // if two lines needed to display buffer
-          set_cursor(num_chars_typed - MAX_CHARS_LINE, 1);    // put cursor right after last char in keyboard buff
-        }
-        else{                                                  // only one line needed
-          set_cursor(num_chars_typed, 0);                      // put cursor right after last char in keyboard buff
+        for(i = ring->commit; i != ring->head; i++){           // display the line still being typed
+          putc(ring->data[i & KB_RING_MASK]);                  // (leaves the cursor right after it)
         }
         // clear buffer?? NO
       }
@@ -230,20 +314,34 @@ void keyboard_handler(void) {
     // case F3_REL_KEYCODE :
     //     alt_pressed = 0;
     //     break;
+    case PAGE_UP_KEYCODE :                                   // shift + page up/down: scrollback
+      if(shift_pressed){
+        scrollback_scroll(&terminals[curr_terminal_id].scrollback, SCROLLBACK_PAGE, terminals[curr_terminal_id].video_mem_addr);
+      }
+      break;
+    case PAGE_DOWN_KEYCODE :
+      if(shift_pressed){
+        scrollback_scroll(&terminals[curr_terminal_id].scrollback, -SCROLLBACK_PAGE, terminals[curr_terminal_id].video_mem_addr);
+      }
+      break;
     case CAPSLOCK_KEYCODE :
       capslock_pressed = !capslock_pressed;                   // toggle from last state
       break;
     case ENTER_KEYCODE :
-      enter_pressed_flag = 1;
-      keyboard_buffer[num_chars_typed] = '\n';
-      num_chars_typed++;
-      putc('\n');                                             // newline
+      scrollback_reset(&terminals[curr_terminal_id].scrollback, terminals[curr_terminal_id].video_mem_addr);
+      if(kb_ring_commit(ring) == 0){                          // the line is now readable
+        sched_wake(&terminals[curr_terminal_id].read_queue);
+        putc('\n');                                           // newline
+      }
       break;
    default :
     print_to_screen(key_code, key_char);
     break;
   }
 
-	sti();                              // set interrupt
+  if(prev_console != -1){
+    console_select(prev_console);         // back to the interrupted process's terminal
+  }
+
 	send_eoi(KEYBOARD_IRQ_NUM);         // end of interrupt
 }
@@ -16,6 +16,8 @@
 #define NUM_CHARS_KB            128                     // max number of bytes (a single char (one byte))
 #define NUM_KB_CODES            0x3A
 #define SIZE_KB_CODES           NUM_KB_CODES + 1        // plus one for empty unmapped val at beginning of scan code set
+#define KB_RING_SIZE            256                     // per-terminal type-ahead, a power of 2
+#define KB_RING_MASK            (KB_RING_SIZE - 1)
 
 /* special characters' & inputs ascii values */         // special inputs are zero (use names to keep track of where they are in the lookup table)
 #define BACKSPACE               0x08
@@ -57,20 +59,32 @@
 #define ENTER_KEYCODE                   0x1C
 #define LETTER_L_KEYCODE                0x26        // for checking for ctrl-L to clear screen
 #define SPACE_KEYCODE                   0x39
+#define PAGE_UP_KEYCODE                 0x49        // with shift: scroll back through the terminal's history
+#define PAGE_DOWN_KEYCODE               0x51
 #define ONE_KEYCODE                     0x02        // for checking if key is in a non-numerical input range (caps + shift lock case)
 
 
 #include "types.h"
 #include "lib.h"
 #include "i8259.h"
+
+/* Single-producer/single-consumer keyboard ring, one per terminal. keyboard_handler
+ * is the only writer of head & commit, terminal_read the only writer of tail, so
+ * neither side locks. Indices run freely and are masked on access.
+ *   [tail, commit)  finished lines (ending in '\n') waiting for terminal_read
+ *   [commit, head)  the line still being typed (backspace can take it back) */
+typedef struct kb_ring{
+    uint8_t data[KB_RING_SIZE];
+    volatile uint32_t head;
+    volatile uint32_t commit;
+    volatile uint32_t tail;
+} kb_ring_t;
+
 #include "terminal_driver.h"
 
 /* Global Variables */
-extern uint8_t keyboard_buffer[NUM_CHARS_KB];                  // global buffer that holds character history from keyboard
 extern uint8_t ascii_lookup_table[SIZE_KB_CODES];              // convert the output from the keyboard to ascii's readable by the screen
 extern uint8_t ascii_caps_lookup_table[SIZE_KB_CODES];         // convert the output from the keyboard to caps version of ascii's readable by the screen
-volatile int enter_pressed_flag;
-volatile int num_chars_typed;                    // number of characters typed (account for backspace)
 
 // extern int num_chars_typed;                                 // number of characters typed (account for backspace)
 // extern bool shift_pressed;                                  // flag to see if shift key was pressed so code can look out for next character
@@ -81,8 +95,12 @@ volatile int num_chars_typed;                    // number of characters typed (
 /* Outputs character from keyboard processed by handler to screen */
 void print_to_screen(uint8_t key_code, uint8_t key_char);
 
-/* Clear keyboard buffer */
-void clear_keyboard_buff(void);
+/* Keyboard ring (producer side runs in keyboard_handler, kb_ring_get in terminal_read) */
+void kb_ring_init(kb_ring_t* ring);
+int32_t kb_ring_put(kb_ring_t* ring, uint8_t c);
+int32_t kb_ring_unput(kb_ring_t* ring);
+int32_t kb_ring_commit(kb_ring_t* ring);
+int32_t kb_ring_get(kb_ring_t* ring, uint8_t* buf, int32_t nbytes);
 
 /* Initializer for keyboard interrupt */
 void keyboard_initialize(void);
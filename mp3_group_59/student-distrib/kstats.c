@@ -0,0 +1,475 @@
+/* kstats.c - Kernel statistics & the pseudo-files that show them
+ * NOTES: systemcall_handler.S counts every call on entry and reads the time-stamp
+ *        counter around the dispatch; syscall_account files the cycles under the
+ *        call's log2 bucket. The interrupt stubs in assembly_linkage.S do the same
+ *        per vector for irq_account. Opening "stats" or "irqstats" gives a text
+ *        rendering of the counters that reads like a regular file, with no entry
+ *        in the filesystem image.
+ */
+#include "kstats.h"
+#include "IDT.h"
+
+uint32_t syscall_calls[SYSCALL_SLOTS];
+static syscall_latency_t syscall_latency[SYSCALL_SLOTS];
+
+uint32_t irq_counts[IRQ_STATS_VECTORS];
+volatile uint32_t irq_switch_epoch;
+static irq_stats_t irq_timing[IRQ_STATS_VECTORS];          // count unused, it lives in irq_counts
+static uint64_t window_start;                               // time-stamp counter at the last reset
+static uint32_t window_ticks;                               // PIT ticks at the last reset
+
+static const int8_t* syscall_names[SYSCALL_SLOTS] = {
+    "invalid", "halt", "execute", "read", "write", "open", "close", "getargs",
+    "vidmap", "set_handler", "sigreturn", "ioctl", "readv", "writev", "io_enter"
+};
+
+static const int8_t* exception_names[] = {
+    "divide_error", "reserved", "nmi", "breakpoint", "overflow", "bound_range",
+    "invalid_opcode", "device_na", "double_fault", "coprocessor_overrun",
+    "invalid_tss", "segment_not_present", "stack_fault", "general_protection",
+    "page_fault", "intel_reserved", "x87_fpu_error", "alignment_check",
+    "machine_check", "simd_error"
+};
+
+/* the statistics files are rendered when read from the start, later reads continue in it */
+
+static int32_t put_number(int8_t* line, int32_t pos, uint32_t value);
+static const int8_t* irq_name(uint32_t vector);
+static int32_t kstats_file_read(int32_t file_index, void* buf, int32_t nbytes,
+                                int32_t (*render)(int8_t* buf, int32_t size));
+
+/*
+ *   FUNCTION: syscall_account
+ *   DESCRIPTION: Files the cycles one system call took
+ *   INPUTS: start -- time-stamp counter read before the dispatch
+ *           num -- call number, already range checked
+ *   OUTPUTS: none
+ *   SIDE EFFECTS: called from systemcall_handler.S with interrupts off
+ */
+void syscall_account(uint64_t start, uint32_t num){
+    syscall_latency_t* lat = &syscall_latency[num];
+    uint64_t cycles = rdtsc() - start;
+    uint32_t clipped = (cycles >> 32) ? 0xFFFFFFFF : (uint32_t)cycles;
+
+    lat->timed++;
+    lat->total_cycles += cycles;
+    if(clipped > lat->max_cycles){
+        lat->max_cycles = clipped;
+    }
+    lat->hist[kstats_bucket(clipped)]++;
+}
+
+/*
+ *   FUNCTION: get_syscall_stats
+ *   DESCRIPTION: Copies out one call's counters
+ *   INPUTS: num -- call number, 0 for the invalid numbers
+ *           stats -- where to copy them
+ *   OUTPUTS: 0 on success, -1 if num is out of range
+ *   SIDE EFFECTS: none
+ */
+int32_t get_syscall_stats(uint32_t num, syscall_stats_t* stats){
+    if(num >= SYSCALL_SLOTS){
+        return -1;
+    }
+    stats->calls = syscall_calls[num];
+    stats->latency = syscall_latency[num];
+    return 0;
+}
+
+/*
+ *   FUNCTION: irq_account
+ *   DESCRIPTION: Files the cycles one interrupt or exception handler took, unless
+ *                the CPU was handed to another context before it returned
+ *   INPUTS: vector -- IDT vector, below IRQ_STATS_VECTORS
+ *           epoch -- irq_switch_epoch when the stub was entered
+ *           start -- time-stamp counter read before the handler
+ *   OUTPUTS: none
+ *   SIDE EFFECTS: called from assembly_linkage.S; interrupts may be on if the
+ *                 handler turned them on
+ */
+void irq_account(uint32_t vector, uint32_t epoch, uint64_t start){
+    irq_stats_t* st = &irq_timing[vector];
+    uint64_t cycles = rdtsc() - start;
+    uint32_t clipped = (cycles >> 32) ? 0xFFFFFFFF : (uint32_t)cycles;
+    uint32_t flags;
+
+    cli_and_save(flags);
+    if(epoch != irq_switch_epoch){
+        st->switched++;
+    }
+    else{
+        if(st->timed == 0 || clipped < st->min_cycles){
+            st->min_cycles = clipped;
+        }
+        if(clipped > st->max_cycles){
+            st->max_cycles = clipped;
+        }
+        st->timed++;
+        st->total_cycles += cycles;
+    }
+    restore_flags(flags);
+}
+
+/*
+ *   FUNCTION: get_irq_stats
+ *   DESCRIPTION: Copies out one vector's counters
+ *   INPUTS: vector -- IDT vector
+ *           stats -- where to copy them
+ *   OUTPUTS: 0 on success, -1 if the vector is not tracked
+ *   SIDE EFFECTS: none
+ */
+int32_t get_irq_stats(uint32_t vector, irq_stats_t* stats){
+    uint32_t flags;
+
+    if(vector >= IRQ_STATS_VECTORS){
+        return -1;
+    }
+    cli_and_save(flags);
+    *stats = irq_timing[vector];
+    stats->count = irq_counts[vector];
+    restore_flags(flags);
+    return 0;
+}
+
+/*
+ *   FUNCTION: get_irq_window
+ *   DESCRIPTION: How long the counters have been collecting, to turn counts into
+ *                rates and cycles into a share of the CPU
+ *   INPUTS: cycles -- time-stamp counter cycles since the last reset
+ *           ticks -- PIT ticks since the last reset
+ *   OUTPUTS: none
+ *   SIDE EFFECTS: none
+ */
+void get_irq_window(uint64_t* cycles, uint32_t* ticks){
+    *cycles = rdtsc() - window_start;
+    *ticks = pit_get_ticks() - window_ticks;
+}
+
+/*
+ *   FUNCTION: kstats_reset
+ *   DESCRIPTION: Zeroes the system call & interrupt counters
+ *   INPUTS: none
+ *   OUTPUTS: none
+ *   SIDE EFFECTS: none
+ */
+void kstats_reset(void){
+    uint32_t flags;
+
+    cli_and_save(flags);
+    memset(syscall_calls, 0, sizeof(syscall_calls));
+    memset(syscall_latency, 0, sizeof(syscall_latency));
+    memset(irq_counts, 0, sizeof(irq_counts));
+    memset(irq_timing, 0, sizeof(irq_timing));
+    window_start = rdtsc();
+    window_ticks = pit_get_ticks();
+    restore_flags(flags);
+}
+
+/*
+ *   FUNCTION: kstats_bucket
+ *   DESCRIPTION: Finds the log2 histogram bucket for a cycle count
+ *   INPUTS: cycles -- measured cycles
+ *   OUTPUTS: index of the highest set bit, 0 for 0 and 1
+ *   SIDE EFFECTS: none
+ */
+uint32_t kstats_bucket(uint32_t cycles){
+    uint32_t bit;
+
+    if(cycles == 0){
+        return 0;
+    }
+    asm("bsrl %1, %0" : "=r"(bit) : "rm"(cycles) : "cc");
+    return bit;
+}
+
+/*
+ *   FUNCTION: kstats_average
+ *   DESCRIPTION: Divides a 64-bit cycle total by a count
+ *   INPUTS: total -- summed cycles
+ *           count -- how many things were summed
+ *   OUTPUTS: the average, 0 if count is 0, 0xFFFFFFFF if it does not fit
+ *   SIDE EFFECTS: none
+ */
+uint32_t kstats_average(uint64_t total, uint32_t count){
+    return kstats_ratio(total, count);
+}
+
+/*
+ *   FUNCTION: kstats_ratio
+ *   DESCRIPTION: 64-bit division without 64-bit division (there is no libgcc):
+ *                both sides are halved until they fit 32 bits
+ *   INPUTS: num, den -- the quotient's operands
+ *   OUTPUTS: num / den, roughly; 0 if den is 0, 0xFFFFFFFF if it does not fit
+ *   SIDE EFFECTS: none
+ */
+uint32_t kstats_ratio(uint64_t num, uint64_t den){
+    if(den == 0){
+        return 0;
+    }
+    while((num >> 32) || (den >> 32)){
+        num >>= 1;
+        den >>= 1;
+    }
+    if(den == 0){
+        return 0xFFFFFFFF;
+    }
+    return (uint32_t)num / (uint32_t)den;
+}
+
+/*
+ *   FUNCTION: syscall_stats_render
+ *   DESCRIPTION: Writes the stats file text: a line for every call number that has
+ *                been used, "name calls timed avg max first count..." where the
+ *                counts run from the first to the last nonzero histogram bucket
+ *   INPUTS: buf -- where to write it
+ *           size -- room in buf
+ *   OUTPUTS: bytes written; lines that do not fit are left out
+ *   SIDE EFFECTS: none
+ */
+int32_t syscall_stats_render(int8_t* buf, int32_t size){
+    int8_t line[NUM_COLS * 6];          // name and 4 + KSTATS_HIST_BUCKETS numbers of up to 10 digits
+    int32_t len = 0, pos;
+    uint32_t num, first, last, b;
+    syscall_latency_t* lat;
+
+    for(num = 0; num < SYSCALL_SLOTS; num++){
+        if(syscall_calls[num] == 0){
+            continue;
+        }
+        lat = &syscall_latency[num];
+
+        pos = strlen(syscall_names[num]);
+        memcpy(line, syscall_names[num], pos);
+        line[pos++] = ' ';
+        pos = put_number(line, pos, syscall_calls[num]);
+        pos = put_number(line, pos, lat->timed);
+        pos = put_number(line, pos, kstats_average(lat->total_cycles, lat->timed));
+        pos = put_number(line, pos, lat->max_cycles);
+
+        for(first = 0; first < KSTATS_HIST_BUCKETS && lat->hist[first] == 0; first++);
+        for(last = KSTATS_HIST_BUCKETS; last > first && lat->hist[last - 1] == 0; last--);
+        if(first < last){
+            pos = put_number(line, pos, first);
+            for(b = first; b < last; b++){
+                pos = put_number(line, pos, lat->hist[b]);
+            }
+        }
+        line[pos - 1] = '\n';
+
+        if(len + pos > size){
+            break;
+        }
+        memcpy(buf + len, line, pos);
+        len += pos;
+    }
+    return len;
+}
+
+/*
+ *   FUNCTION: irq_stats_render
+ *   DESCRIPTION: Writes the irqstats file text: a line for every vector taken since
+ *                the last reset, "vector name count per_second timed avg min max
+ *                cost_permille switched"
+ *   INPUTS: buf -- where to write it
+ *           size -- room in buf
+ *   OUTPUTS: bytes written; lines that do not fit are left out
+ *   SIDE EFFECTS: none
+ */
+int32_t irq_stats_render(int8_t* buf, int32_t size){
+    int8_t line[NUM_COLS * 2];
+    int32_t len = 0, pos;
+    uint32_t vector, ticks;
+    uint64_t cycles;
+    irq_stats_t st;
+
+    get_irq_window(&cycles, &ticks);
+    for(vector = 0; vector < IRQ_STATS_VECTORS; vector++){
+        get_irq_stats(vector, &st);
+        if(st.count == 0){
+            continue;
+        }
+        pos = put_number(line, 0, vector);
+        memcpy(line + pos, irq_name(vector), strlen(irq_name(vector)));
+        pos += strlen(irq_name(vector));
+        line[pos++] = ' ';
+        pos = put_number(line, pos, st.count);
+        pos = put_number(line, pos, kstats_ratio((uint64_t)st.count * PIT_HZ, ticks));
+        pos = put_number(line, pos, st.timed);
+        pos = put_number(line, pos, kstats_average(st.total_cycles, st.timed));
+        pos = put_number(line, pos, st.min_cycles);
+        pos = put_number(line, pos, st.max_cycles);
+        pos = put_number(line, pos, kstats_ratio(st.total_cycles * 1000, cycles));
+        pos = put_number(line, pos, st.switched);
+        line[pos - 1] = '\n';
+
+        if(len + pos > size){
+            break;
+        }
+        memcpy(buf + len, line, pos);
+        len += pos;
+    }
+    return len;
+}
+
+/*
+ *   FUNCTION: irq_name
+ *   DESCRIPTION: Names a vector for the irqstats file
+ *   INPUTS: vector -- IDT vector
+ *   OUTPUTS: the exception or device name, "irq" for an unnamed PIC line
+ *   SIDE EFFECTS: none
+ */
+static const int8_t* irq_name(uint32_t vector){
+    if(vector < sizeof(exception_names) / sizeof(exception_names[0])){
+        return exception_names[vector];
+    }
+    switch(vector){
+        case PIT_IRQ_VECTOR: return "pit";
+        case KEYBOARD_IRQ: return "keyboard";
+        case RTC_IRQ: return "rtc";
+    }
+    return (vector < IRQ_MAPPED) ? "intel_reserved" : "irq";
+}
+
+/*
+ *   FUNCTION: put_number
+ *   DESCRIPTION: Appends a decimal number and a space to a line
+ *   INPUTS: line -- line being built
+ *           pos -- where the number goes
+ *           value -- the number
+ *   OUTPUTS: position after the space
+ *   SIDE EFFECTS: none
+ */
+static int32_t put_number(int8_t* line, int32_t pos, uint32_t value){
+    itoa(value, line + pos, 10);
+    pos += strlen(line + pos);
+    line[pos++] = ' ';
+    return pos;
+}
+
+/*
+ *   FUNCTION: kstats_snapshot_alloc
+ *   DESCRIPTION: Gives a newly opened stats or irqstats file the frames its text
+ *                is rendered into
+ *   INPUTS: desc -- the file descriptor
+ *   OUTPUTS: 0 on success, -1 if out of memory
+ *   SIDE EFFECTS: takes KSTATS_SNAPSHOT_FRAMES frames until kstats_snapshot_free
+ */
+int32_t kstats_snapshot_alloc(file_descriptor_t* desc){
+    uint32_t frames = frame_alloc_contig(KSTATS_SNAPSHOT_FRAMES);
+
+    if(frames == FRAME_NONE){
+        return -1;
+    }
+    desc->stats_snapshot = (kstats_snapshot_t*)frames;
+    desc->stats_snapshot->length = 0;
+    return 0;
+}
+
+/*
+ *   FUNCTION: kstats_snapshot_free
+ *   DESCRIPTION: Releases a closing file's snapshot, if it has one
+ *   INPUTS: desc -- the file descriptor
+ *   OUTPUTS: none
+ *   SIDE EFFECTS: none
+ */
+void kstats_snapshot_free(file_descriptor_t* desc){
+    if(desc->stats_snapshot != NULL){
+        frame_free_contig((uint32_t)desc->stats_snapshot, KSTATS_SNAPSHOT_FRAMES);
+        desc->stats_snapshot = NULL;
+    }
+}
+
+/*
+ *   FUNCTION: kstats_file_read
+ *   DESCRIPTION: Reads a statistics file like a regular file; a read from the start
+ *                takes a fresh snapshot of the counters into the descriptor's own
+ *                buffer, so other open statistics files don't disturb it
+ *   INPUTS: file_index -- fd of the open file
+ *           buf -- where to copy to
+ *           nbytes -- most bytes to copy
+ *           render -- writes the file's text
+ *   OUTPUTS: bytes copied, 0 at the end of the text
+ *   SIDE EFFECTS: moves the file position
+ */
+static int32_t kstats_file_read(int32_t file_index, void* buf, int32_t nbytes,
+                                int32_t (*render)(int8_t* buf, int32_t size)){
+    file_descriptor_t* desc = pcb_obj->fda[file_index];
+    kstats_snapshot_t* snapshot = desc->stats_snapshot;
+    int32_t left;
+
+    if(nbytes < 0 || snapshot == NULL){
+        return -1;
+    }
+    if(desc->file_position == 0){
+        snapshot->length = render(snapshot->text, KSTATS_TEXT_SIZE);
+    }
+    if(desc->file_position >= snapshot->length){
+        return 0;
+    }
+    left = snapshot->length - desc->file_position;
+    if(nbytes > left){
+        nbytes = left;
+    }
+    memcpy(buf, snapshot->text + desc->file_position, nbytes);
+    desc->file_position += nbytes;
+    return nbytes;
+}
+
+/*
+ *   FUNCTION: stats_read
+ *   DESCRIPTION: Reads the system call statistics
+ *   INPUTS: file_index -- fd of the open stats file
+ *           buf -- where to copy to
+ *           nbytes -- most bytes to copy
+ *   OUTPUTS: bytes copied, 0 at the end of the text
+ *   SIDE EFFECTS: moves the file position
+ */
+int32_t stats_read(int32_t file_index, void* buf, int32_t nbytes){
+    return kstats_file_read(file_index, buf, nbytes, syscall_stats_render);
+}
+
+/*
+ *   FUNCTION: irqstats_read
+ *   DESCRIPTION: Reads the interrupt statistics
+ *   INPUTS: file_index -- fd of the open irqstats file
+ *           buf -- where to copy to
+ *           nbytes -- most bytes to copy
+ *   OUTPUTS: bytes copied, 0 at the end of the text
+ *   SIDE EFFECTS: moves the file position
+ */
+int32_t irqstats_read(int32_t file_index, void* buf, int32_t nbytes){
+    return kstats_file_read(file_index, buf, nbytes, irq_stats_render);
+}
+
+/*
+ *   FUNCTION: stats_write
+ *   DESCRIPTION: The stats file is read only
+ *   INPUTS: ignored
+ *   OUTPUTS: -1
+ *   SIDE EFFECTS: none
+ */
+int32_t stats_write(int32_t file_index, const void* buf, int32_t nbytes){
+    return -1;
+}
+
+/*
+ *   FUNCTION: stats_open
+ *   DESCRIPTION: Nothing to set up, system_open hands out the descriptor
+ *   INPUTS: ignored
+ *   OUTPUTS: 0
+ *   SIDE EFFECTS: none
+ */
+int32_t stats_open(const uint8_t* file_name){
+    return 0;
+}
+
+/*
+ *   FUNCTION: stats_close
+ *   DESCRIPTION: Nothing to tear down
+ *   INPUTS: ignored
+ *   OUTPUTS: 0
+ *   SIDE EFFECTS: none
+ */
+int32_t stats_close(int32_t file_index){
+    return 0;
+}
@@ -0,0 +1,94 @@
+/* kstats.h - Defines & headers for the kernel statistics & the pseudo-files that show them
+ * NOTES: system call & interrupt counters are bumped straight from systemcall_handler.S
+ *        and assembly_linkage.S, so the layout of syscall_calls[] & irq_counts[] is
+ *        shared with the assembly
+ */
+
+#ifndef _KSTATS_H
+#define _KSTATS_H
+
+#include "types.h"
+#include "lib.h"
+#include "filesystem.h"
+#include "frame.h"
+#include "pit.h"
+
+#define SYSCALL_SLOTS           15                          // call numbers 1..14, slot 0 counts invalid numbers
+#define KSTATS_HIST_BUCKETS     32                          // log2 buckets: bucket b holds [2^b, 2^(b+1)) cycles
+#define KSTATS_SNAPSHOT_FRAMES  2                           // 4KB frames behind each open file's snapshot
+#define KSTATS_TEXT_SIZE        (KSTATS_SNAPSHOT_FRAMES * FRAME_SIZE - 4)   // the rest after the length
+#define STATS_FILE_NAME         "stats"
+#define STATS_FILE_TYPE         4                           // fd file_type of an open stats file
+#define IRQ_STATS_VECTORS       0x30                        // exceptions 0x00-0x1F & PIC interrupts 0x20-0x2F
+#define IRQSTATS_FILE_NAME      "irqstats"
+#define IRQSTATS_FILE_TYPE      5
+
+/* Per call latency, for the calls that came back through the dispatcher
+ * (halt never does, and execute only returns once its program has halted) */
+typedef struct syscall_latency{
+    uint32_t timed;                                         // calls measured
+    uint64_t total_cycles;
+    uint32_t max_cycles;
+    uint32_t hist[KSTATS_HIST_BUCKETS];
+} syscall_latency_t;
+
+typedef struct syscall_stats{
+    uint32_t calls;                                         // entries, counted before dispatch
+    syscall_latency_t latency;
+} syscall_stats_t;
+
+/* Per vector handler time. A handler that was switched away from (the PIT tick
+ * running the scheduler, or anything it interrupted) is counted but not timed,
+ * since it only came back once this context was scheduled again */
+typedef struct irq_stats{
+    uint32_t count;                                         // entries, counted before the handler
+    uint32_t timed;
+    uint32_t switched;                                      // returned on a later schedule
+    uint64_t total_cycles;
+    uint32_t min_cycles;
+    uint32_t max_cycles;
+} irq_stats_t;
+
+/* The text an open stats or irqstats file reads from, rendered when it is read
+ * from the start, so two open files never see each other's text */
+typedef struct kstats_snapshot{
+    int32_t length;
+    int8_t text[KSTATS_TEXT_SIZE];
+} kstats_snapshot_t;
+
+extern uint32_t syscall_calls[SYSCALL_SLOTS];               // bumped by systemcall_handler.S
+extern uint32_t irq_counts[IRQ_STATS_VECTORS];              // bumped by assembly_linkage.S
+extern volatile uint32_t irq_switch_epoch;                  // bumped by sched_switch
+
+/* called by systemcall_handler.S once a call returns */
+void syscall_account(uint64_t start, uint32_t num);
+int32_t get_syscall_stats(uint32_t num, syscall_stats_t* stats);
+void kstats_reset(void);
+uint32_t kstats_bucket(uint32_t cycles);
+uint32_t kstats_average(uint64_t total, uint32_t count);
+uint32_t kstats_ratio(uint64_t num, uint64_t den);
+int32_t syscall_stats_render(int8_t* buf, int32_t size);
+
+/* called by assembly_linkage.S once a handler returns */
+void irq_account(uint32_t vector, uint32_t epoch, uint64_t start);
+int32_t get_irq_stats(uint32_t vector, irq_stats_t* stats);
+void get_irq_window(uint64_t* cycles, uint32_t* ticks);
+int32_t irq_stats_render(int8_t* buf, int32_t size);
+
+/* system_open & system_close give each open stats or irqstats file its snapshot */
+int32_t kstats_snapshot_alloc(file_descriptor_t* desc);
+void kstats_snapshot_free(file_descriptor_t* desc);
+
+/* the stats pseudo-file: one line per call that has been made,
+ *   name calls timed avg max first_bucket count[first_bucket] ... count[last nonzero bucket] */
+int32_t stats_read(int32_t file_index, void* buf, int32_t nbytes);
+int32_t stats_write(int32_t file_index, const void* buf, int32_t nbytes);
+int32_t stats_open(const uint8_t* file_name);
+int32_t stats_close(int32_t file_index);
+
+/* the irqstats pseudo-file: a line for every vector taken since the last reset,
+ *   vector name count per_second timed avg min max cost_permille switched
+ * where cost_permille is the share of all cycles spent in the timed handlers */
+int32_t irqstats_read(int32_t file_index, void* buf, int32_t nbytes);
+
+#endif /* _KSTATS_H */
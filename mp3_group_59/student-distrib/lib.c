@@ -2,13 +2,20 @@
  * vim:ts=4 noexpandtab */
 
 #include "lib.h"
+#include "terminal_driver.h"
 
 #define VIDEO       0xB8000
 #define ATTRIB      0x7
+#define USER_SPACE_START    0x8000000   // 128MB, the program page
+#define USER_SPACE_END      0x8400000   // 132MB
 
 static int screen_x;
 static int screen_y;
 static char* video_mem = (char *)VIDEO;
+static int32_t console_terminal = -1;      // terminal putc writes to, -1 for the boot screen at VIDEO
+
+static void update_hw_cursor(void);
+static void scroll_video(void);
 
 /* void clear(void);
  * Inputs: void
@@ -40,14 +47,68 @@ void clear_terminal_vidmem(uint32_t terminal_vidmem_addr) {
  * Return Value: none
  * Function: set cursor location */
 void set_cursor(uint32_t x, uint32_t y){
-    uint16_t pos = NUM_COLS * y + x;
-   
+    screen_x = x;
+    screen_y = y;
+    update_hw_cursor();
+}
+
+/* void update_hw_cursor
+ * Inputs: void
+ * Return Value: none
+ * Function: move the VGA cursor to screen_x/screen_y; four CRTC port
+ *           writes, so batched writers call this once at the end. Only
+ *           the console on screen owns the cursor, and its location is
+ *           counted from the start of the VGA window, not of the page */
+static void update_hw_cursor(void){
+    uint16_t pos;
+
+    if (console_terminal != -1 && console_terminal != curr_terminal_id) {
+        return;
+    }
+    pos = (((uint32_t)video_mem - VIDEO) >> 1) + NUM_COLS * screen_y + screen_x;
+
 	outb(0x0F, 0x3D4);
 	outb((uint8_t) (pos & 0xFF), 0x3D5);
 	outb(0x0E, 0x3D4);
 	outb((uint8_t) ((pos >> 8) & 0xFF), 0x3D5);
-    screen_x = x;
-    screen_y = y;
+}
+
+/* void set_display_start
+ * Inputs: addr = text page (in the 0xB8000 window) to show
+ * Return Value: none
+ * Function: point the VGA CRTC start address at addr, so the screen shows
+ *           that page without copying it; text mode counts in cells */
+void set_display_start(uint32_t addr){
+    uint16_t start = (addr - VIDEO) >> 1;
+
+	outb(0x0C, 0x3D4);
+	outb((uint8_t) ((start >> 8) & 0xFF), 0x3D5);
+	outb(0x0D, 0x3D4);
+	outb((uint8_t) (start & 0xFF), 0x3D5);
+}
+
+/* int32_t console_select
+ * Inputs: terminal_id = terminal whose text page putc/printf write to next
+ * Return Value: the terminal that was selected before
+ * Function: park the current console's cursor in its terminal and pick up
+ *           the new one's page & cursor, so every terminal is written in
+ *           place whether it is on screen or not */
+int32_t console_select(int32_t terminal_id){
+    int32_t prev = console_terminal;
+
+    if (terminal_id == prev) {
+        return prev;
+    }
+    if (prev != -1) {
+        terminals[prev].screen_X = screen_x;
+        terminals[prev].screen_Y = screen_y;
+    }
+    console_terminal = terminal_id;
+    video_mem = (char *)terminals[terminal_id].video_mem_addr;
+    screen_x = terminals[terminal_id].screen_X;
+    screen_y = terminals[terminal_id].screen_Y;
+    update_hw_cursor();
+    return prev;
 }
 
 /* void get_screen_x
@@ -71,25 +132,87 @@ uint32_t get_screen_y(void){
  * Return Value: none
  * Function: set cursor location */
 void scrolling(void){
-     int i;
-    int j;
-    for(j = 1; j < NUM_ROWS; j++) {
-        for(i = 0; i < NUM_COLS; i++) {
-            *(uint8_t *)(video_mem + ((NUM_COLS * (j - 1) + i) << 1)) =
-            *(uint8_t *)(video_mem + ((NUM_COLS * j + i) << 1));
-            *(uint8_t *)(video_mem + ((NUM_COLS * (j - 1) + i) << 1) + 1) = ATTRIB;
-
-            if(j == (NUM_ROWS - 1)) {
-                *(uint8_t *)(video_mem + ((NUM_COLS * j + i) << 1)) = ' ';
-                *(uint8_t *)(video_mem + ((NUM_COLS * j + i) << 1) + 1) = ATTRIB;
-            }
-        }
-    }
+    scroll_video();
     set_cursor(0,NUM_ROWS-1);
     
     return;
 }
 
+/* void scroll_video
+ * Inputs: void
+ * Return Value: none
+ * Function: move video memory up one row and blank the bottom row,
+ *           leaving the cursor alone; one bulk move of the top 24 rows
+ *           and one word fill instead of a store per byte. The top row goes
+ *           into the console's scrollback first */
+static void scroll_video(void){
+    if (console_terminal != -1) {
+        scrollback_push(&terminals[console_terminal].scrollback, (uint16_t *)video_mem);
+    }
+    memmove(video_mem, video_mem + (NUM_COLS << 1), ((NUM_ROWS - 1) * NUM_COLS) << 1);
+    memset_word(video_mem + (((NUM_ROWS - 1) * NUM_COLS) << 1), (ATTRIB << 8) | ' ', NUM_COLS);
+}
+
+/* int32_t putbuf(const int8_t* buf, int32_t n);
+ * Inputs: buf = characters to print
+ *           n = number of characters in buf
+ * Return Value: number of characters consumed; stops early at a NUL
+ * Function: batched putc. Each run of characters up to the next newline or
+ *           the end of the row is stored straight into video memory as
+ *           character/attribute words, scrolling as rows fill, and the
+ *           hardware cursor is moved once at the end */
+int32_t putbuf(const int8_t* buf, int32_t n){
+    uint16_t* cell;
+    int32_t i = 0;
+    int32_t run;
+    uint8_t c;
+
+    while (i < n) {
+        c = buf[i];
+        if (c == '\0') {
+            break;
+        }
+        if (c == '\n' || c == '\r') {
+            screen_x = 0;
+            if (screen_y == NUM_ROWS - 1) {
+                scroll_video();
+            } else {
+                screen_y++;
+            }
+            i++;
+            continue;
+        }
+
+        /* copy up to the end of the row, stopping at a newline or NUL */
+        cell = (uint16_t *)video_mem + NUM_COLS * screen_y + screen_x;
+        run = NUM_COLS - screen_x;
+        if (run > n - i) {
+            run = n - i;
+        }
+        while (run-- > 0) {
+            c = buf[i];
+            if (c == '\0' || c == '\n' || c == '\r') {
+                break;
+            }
+            *cell++ = (ATTRIB << 8) | c;
+            screen_x++;
+            i++;
+        }
+
+        if (screen_x == NUM_COLS) {
+            screen_x = 0;
+            if (screen_y == NUM_ROWS - 1) {
+                scroll_video();
+            } else {
+                screen_y++;
+            }
+        }
+    }
+
+    update_hw_cursor();
+    return i;
+}
+
 /* Standard printf().
  * Only supports the following format strings:
  * %%  - print a literal '%' character
@@ -467,20 +590,22 @@ void* memcpy(void* dest, const void* src, uint32_t n) {
  * Return Value: pointer to dest
  * Function: move n bytes of src to dest */
 void* memmove(void* dest, const void* src, uint32_t n) {
+    void* to = dest;
     asm volatile ("                             \n\
             movw    %%ds, %%dx                  \n\
             movw    %%dx, %%es                  \n\
             cld                                 \n\
             cmp     %%edi, %%esi                \n\
-            jae     .memmove_go                 \n\
+            jae     1f                          \n\
             leal    -1(%%esi, %%ecx), %%esi     \n\
             leal    -1(%%edi, %%ecx), %%edi     \n\
             std                                 \n\
-            .memmove_go:                        \n\
+            1:                                  \n\
             rep     movsb                       \n\
+            cld                                 \n\
             "
+            : "+D"(to), "+S"(src), "+c"(n)      /* rep movsb moves all three */
             :
-            : "D"(dest), "S"(src), "c"(n)
             : "edx", "memory", "cc"
     );
     return dest;
@@ -547,6 +672,19 @@ int8_t* strncpy(int8_t* dest, const int8_t* src, uint32_t n) {
     return dest;
 }
 
+/* int32_t bad_userspace_addr(const void* addr, int32_t len)
+ * Inputs: const void* addr = start of a buffer handed in by a program
+ *              int32_t len = its length in bytes
+ * Return Value: 1 if any byte falls outside the program page, 0 if it is all inside
+ * Function: checks a user buffer before the kernel reads or writes it */
+int32_t bad_userspace_addr(const void* addr, int32_t len) {
+    uint32_t start = (uint32_t)addr;
+    if (len < 0 || start < USER_SPACE_START || start >= USER_SPACE_END) {
+        return 1;
+    }
+    return (uint32_t)len > USER_SPACE_END - start;
+}
+
 /* void test_interrupts(void)
  * Inputs: void
  * Return Value: void
@@ -12,6 +12,7 @@
 
 int32_t printf(int8_t *format, ...);
 void putc(uint8_t c);
+int32_t putbuf(const int8_t* buf, int32_t n);
 int32_t puts(int8_t *s);
 int8_t *itoa(uint32_t value, int8_t* buf, int32_t radix);
 int8_t *strrev(int8_t* s);
@@ -20,6 +21,8 @@ void clear(void);
 void clear_terminal_vidmem(uint32_t terminal_vidmem_addr);
 /* set screen_x and screen_y */
 void set_cursor(uint32_t x, uint32_t y);
+void set_display_start(uint32_t addr);
+int32_t console_select(int32_t terminal_id);
 void scrolling(void);
 uint32_t get_screen_x(void);
 uint32_t get_screen_y(void);
@@ -164,4 +167,35 @@ do {                                    \
     );                                  \
 } while (0)
 
+/* Read the time-stamp counter
+ * Returns the 64-bit cycle count; only take differences of it
+ * (callers truncate short intervals to 32 bits to avoid 64-bit division) */
+static inline uint64_t rdtsc(void) {
+    uint64_t val;
+    asm volatile ("rdtsc"
+            : "=A"(val)
+            :
+            : "memory"
+    );
+    return val;
+}
+
+/* Write a model-specific register */
+static inline void wrmsr(uint32_t msr, uint32_t low, uint32_t high) {
+    asm volatile ("wrmsr"
+            :
+            : "c"(msr), "a"(low), "d"(high)
+            : "memory"
+    );
+}
+
+/* Read the feature flags in edx of CPUID leaf 1 */
+static inline uint32_t cpuid_features(void) {
+    uint32_t eax = 1, ebx, ecx, edx;
+    asm volatile ("cpuid"
+            : "+a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx)
+    );
+    return edx;
+}
+
 #endif /* _LIB_H */
@@ -1,7 +1,13 @@
 #include "paging.h"
+#include "scrollback.h"
 
 extern void enable(uint32_t directory);
 
+static paging_stats_t paging_stats;
+static program_image_t program_images[MAX_PROCESSES];      // image behind each program page table
+static page_table_entry_t* program_tables[MAX_PROCESSES];  // program page table frame for each pid, NULL if none
+static int32_t program_current = -1;                        // pid whose table is in the page directory
+
 // /* Initialize Paging */
 void paging_init(void)
 {
@@ -17,7 +23,7 @@ void paging_init(void)
     pde.accessed           = 0;
     pde.reserved           = 0;
     pde.size               = 0;//4KB
-    pde.ignored            = 0;
+    pde.global             = 0;//ignored for a page table
     pde.avail              = 0;
     pde.table_addr         =((uint32_t)kernel_page_table) >> 12;//the address needs to move to highest 20 bits
 
@@ -32,13 +38,13 @@ void paging_init(void)
     kernel_page_directory[1].accessed           = 0;
     kernel_page_directory[1].reserved           = 0;
     kernel_page_directory[1].size               = 1;//4MB
-    kernel_page_directory[1].ignored            = 0;
+    kernel_page_directory[1].global             = 1;//kernel mapping survives CR3 reloads
     kernel_page_directory[1].avail              = 0;
     kernel_page_directory[1].table_addr         = SIZE_4MB >> 12;//kernel addr,4MB of virtual memory----4MB of physical memory
 
-    //set up the rest
+    //set up the rest (the frame pool is identity mapped for the kernel only)
     for (i=2 ; i < SPACE ; i++){
-        kernel_page_directory[i].present            = 0;
+        kernel_page_directory[i].present            = (i < FRAME_POOL_END / SIZE_4MB) ? 1 : 0;
         kernel_page_directory[i].read_write         = 1;
         kernel_page_directory[i].user               = 0;
         kernel_page_directory[i].write_through      = 0;
@@ -46,9 +52,9 @@ void paging_init(void)
         kernel_page_directory[i].accessed           = 0;
         kernel_page_directory[i].reserved           = 0;
         kernel_page_directory[i].size               = 1;//4MB
-        kernel_page_directory[i].ignored            = 0;
+        kernel_page_directory[i].global             = (i < FRAME_POOL_END / SIZE_4MB) ? 1 : 0;
         kernel_page_directory[i].avail              = 0;
-        kernel_page_directory[i].table_addr         = i;
+        kernel_page_directory[i].table_addr         = (i < FRAME_POOL_END / SIZE_4MB) ? ((uint32_t)i * SIZE_4MB) >> 12 : 0;//identity, 4MB of virtual memory----4MB of physical memory
     }
 
     //pte
@@ -62,7 +68,7 @@ void paging_init(void)
             kernel_page_table[i].accessed           = 0;
             kernel_page_table[i].dirty              = 0;
             kernel_page_table[i].reserved           = 0;
-            kernel_page_table[i].global             = 0;
+            kernel_page_table[i].global             = 1;
             kernel_page_table[i].avail              = 0;
             kernel_page_table[i].page_addr          = VIDEO_ADDR;
         }
@@ -83,28 +89,249 @@ void paging_init(void)
     enable((uint32_t)kernel_page_directory);
 }
 /*Function: execute_paging_init ( uint32_t pid )
- *Description: set up the page directory for the program
- *Input: pid
+ *Description: point the program image page directory entry at the process's 4KB page table
+ *Input: pid + 1 (0 unmaps the program region)
  *Output: none
- *Side effect: also flush the TLB using flush_tlb()
-* calculate the physical address of the page
+ *Side effect: also flush the TLB using flush_tlb(); the kernel & video mappings are global,
+ *             so only the user entries are dropped (cheaper than 1024 invlpgs for the region)
  */
 void execute_paging_init(uint32_t pid){
-    int phy_addr = SIZE_8MB + (SIZE_4MB * (pid - 1));
-    kernel_page_directory[PROGRAM_IMG_PDE_INDEX].present = 1;
-    kernel_page_directory[PROGRAM_IMG_PDE_INDEX].user= 1;
-    kernel_page_directory[PROGRAM_IMG_PDE_INDEX].table_addr = (phy_addr/SIZE_4KB/SPACE) << 10;
+    if(pid == 0 || pid > MAX_PROCESSES || program_tables[pid - 1] == NULL){
+        kernel_page_directory[PROGRAM_IMG_PDE_INDEX].present = 0;
+        program_current = -1;
+    }
+    else{
+        kernel_page_directory[PROGRAM_IMG_PDE_INDEX].present = 1;
+        kernel_page_directory[PROGRAM_IMG_PDE_INDEX].user = 1;
+        kernel_page_directory[PROGRAM_IMG_PDE_INDEX].read_write = 1;
+        kernel_page_directory[PROGRAM_IMG_PDE_INDEX].size = 0; //4KB
+        kernel_page_directory[PROGRAM_IMG_PDE_INDEX].table_addr = (uint32_t)program_tables[pid - 1] >> 12;
+        program_current = pid - 1;
+    }
 
     flush_tlb((int)kernel_page_directory);
 }
 
-/*Function: map_vidmem ( )
- *Description: map the video memory to the user space
- *Input: none
+/*Function: set_program_pte ( page_table_entry_t* pte, uint32_t phys_addr, uint32_t shared )
+ *Description: fill one user page table entry
+ *Input: entry, physical page address, 1 to map read-only copy-on-write
  *Output: none
- *Side effect: also flush the TLB using flush_tlb()
  */
-void map_vidmem(){
+static void set_program_pte(page_table_entry_t* pte, uint32_t phys_addr, uint32_t shared){
+    pte->present            = 1;
+    pte->read_write         = shared ? 0 : 1;
+    pte->user               = 1;
+    pte->write_through      = 0;
+    pte->cache_disable      = 0;
+    pte->accessed           = 0;
+    pte->dirty              = 0;
+    pte->reserved           = 0;
+    pte->global             = 0;
+    pte->avail              = shared ? PTE_AVAIL_COW : 0;
+    pte->page_addr          = phys_addr >> 12;
+}
+
+/*Function: program_paging_init ( uint32_t pid, exec_cache_entry_t* exe )
+ *Description: build the 4KB page table for a process's program region in a fresh frame.
+ *             Nothing is mapped up front: image pages are filled by program_page_fault on
+ *             first touch and the rest of the region gets zeroed frames the same way.
+ *Input: pid, validated executable from the exec cache
+ *Output: 0 on success, -1 if there is no frame for the table
+ *Side effect: does not touch the page directory (see execute_paging_init)
+ */
+int32_t program_paging_init(uint32_t pid, exec_cache_entry_t* exe){
+    page_table_entry_t* table;
+    uint32_t image_pages = (exe->length + SIZE_4KB - 1) / SIZE_4KB;
+    uint32_t i;
+
+    if(pid >= MAX_PROCESSES){
+        return -1;
+    }
+    program_paging_free(pid);
+    table = (page_table_entry_t*)frame_alloc();
+    if(table == (page_table_entry_t*)FRAME_NONE){
+        return -1;
+    }
+    memset(table, 0, SIZE_4KB);
+    program_tables[pid] = table;
+
+    program_images[pid].entry = exe;
+    program_images[pid].image = exe->image;
+    program_images[pid].inode = exe->inode;
+    program_images[pid].length = exe->length;
+
+    for(i = PROGRAM_IMG_FIRST_PTE; i < SPACE; i++){              // nothing lives below the image
+        if(i - PROGRAM_IMG_FIRST_PTE < image_pages){
+            table[i].avail = PTE_AVAIL_DEMAND;                      // loaded on first touch
+        }
+        else{
+            table[i].avail = PTE_AVAIL_ZERO;                        // bss, heap & stack
+        }
+    }
+    return 0;
+}
+
+/*Function: program_paging_free ( uint32_t pid )
+ *Description: give a process's private frames and its page table back to the frame pool.
+ *             Shared pages belong to the exec cache and are left alone.
+ *Input: pid
+ *Output: none
+ *Side effect: the caller must have switched the page directory away from this table
+ */
+void program_paging_free(uint32_t pid){
+    page_table_entry_t* table;
+    uint32_t i;
+
+    if(pid >= MAX_PROCESSES || program_tables[pid] == NULL){
+        return;
+    }
+    table = program_tables[pid];
+    for(i = PROGRAM_IMG_FIRST_PTE; i < SPACE; i++){
+        if(table[i].present && !(table[i].avail & PTE_AVAIL_COW)){
+            frame_free(table[i].page_addr << 12);
+        }
+    }
+    frame_free((uint32_t)table);
+    program_tables[pid] = NULL;
+    if(program_current == (int32_t)pid){
+        program_current = -1;
+    }
+}
+
+/*Function: program_private_frame ( page_table_entry_t* pte, uint32_t page_addr )
+ *Description: map a fresh private frame for one program page
+ *Input: entry for the page, page virtual address
+ *Output: 0 if mapped, -1 if the frame pool is empty
+ */
+static int32_t program_private_frame(page_table_entry_t* pte, uint32_t page_addr){
+    uint32_t frame = frame_alloc();
+
+    if(frame == FRAME_NONE){
+        return -1;
+    }
+    set_program_pte(pte, frame, 0);
+    invlpg(page_addr);
+    return 0;
+}
+
+/*Function: program_demand_fault ( uint32_t pid, page_table_entry_t* pte, uint32_t index, uint32_t page_addr )
+ *Description: first touch of an image page. Cached images map the (paged in) pristine copy
+ *             shared copy-on-write; uncached images read the page from the file into a
+ *             private frame.
+ *Input: pid, entry for the page, page table index, page virtual address
+ *Output: 0 if the page was mapped, -1 otherwise
+ */
+static int32_t program_demand_fault(uint32_t pid, page_table_entry_t* pte, uint32_t index, uint32_t page_addr){
+    program_image_t* program = &program_images[pid];
+    uint32_t page = index - PROGRAM_IMG_FIRST_PTE;
+    uint32_t offset = page * SIZE_4KB;
+    uint32_t length;
+    uint8_t* shared_page;
+
+    paging_stats.demand_faults++;
+
+    if(program->image != NULL){
+        shared_page = exec_cache_page_in(program->entry, page);
+        if(shared_page == NULL){
+            return -1;
+        }
+        set_program_pte(pte, (uint32_t)shared_page, 1);             // a write retries into the COW path
+        paging_stats.shared_pages_mapped++;
+        invlpg(page_addr);
+        return 0;
+    }
+
+    if(program_private_frame(pte, page_addr) != 0){
+        return -1;
+    }
+    length = program->length - offset;
+    if(length > SIZE_4KB){
+        length = SIZE_4KB;
+    }
+    if(read_data(program->inode, offset, (uint8_t*)page_addr, length) != length){
+        return -1;
+    }
+    memset((uint8_t*)page_addr + length, 0, SIZE_4KB - length);     // zero the tail past the end of the file
+    paging_stats.demand_file_reads++;
+    return 0;
+}
+
+/*Function: program_page_fault ( uint32_t fault_addr, uint32_t error_code )
+ *Description: handle program region faults: first touches of image pages are loaded, and
+ *             writes to shared pages give the current process its own copy
+ *Input: faulting address (CR2), page fault error code
+ *Output: 0 if the fault was handled, -1 if it is a real fault
+ */
+int32_t program_page_fault(uint32_t fault_addr, uint32_t error_code){
+    page_directory_entry_t* pde = &kernel_page_directory[PROGRAM_IMG_PDE_INDEX];
+    page_table_entry_t* table;
+    page_table_entry_t* pte;
+    uint32_t index;
+    uint32_t pid;
+    uint32_t shared_addr;
+    uint32_t page_addr = fault_addr & ~(SIZE_4KB - 1);
+
+    if((fault_addr >> 22) != PROGRAM_IMG_PDE_INDEX || !pde->present || pde->size){
+        return -1;
+    }
+
+    if(program_current < 0){
+        return -1;
+    }
+
+    pid = program_current;
+    table = program_tables[pid];
+    index = (fault_addr >> 12) & (SPACE - 1);
+    pte = &table[index];
+
+    if(!(error_code & PF_ERR_PRESENT)){
+        if(pte->avail & PTE_AVAIL_DEMAND){
+            return program_demand_fault(pid, pte, index, page_addr);
+        }
+        if(pte->avail & PTE_AVAIL_ZERO){
+            if(program_private_frame(pte, page_addr) != 0){
+                return -1;
+            }
+            memset((void*)page_addr, 0, SIZE_4KB);
+            paging_stats.private_pages_mapped++;
+            return 0;
+        }
+        return -1;
+    }
+    if(!(error_code & PF_ERR_WRITE) || !(pte->avail & PTE_AVAIL_COW)){
+        return -1;
+    }
+
+    /* remap to a private frame, then fill it through the user address */
+    shared_addr = pte->page_addr << 12;                             // exec cache pages are identity mapped
+    if(program_private_frame(pte, page_addr) != 0){
+        return -1;
+    }
+    memcpy((void*)page_addr, (void*)shared_addr, SIZE_4KB);
+
+    paging_stats.cow_faults++;
+    return 0;
+}
+
+/*Function: paging_get_stats ( paging_stats_t* stats )
+ *Description: copy out the shared page counters
+ *Input: stats -- filled with the current counters
+ *Output: none
+ */
+void paging_get_stats(paging_stats_t* stats){
+    if(stats == NULL){
+        return;
+    }
+    *stats = paging_stats;
+}
+
+/*Function: map_vidmem ( uint32_t page )
+ *Description: map a terminal's text page to the user space
+ *Input: page -- address of the text page (in the 0xB8000 window)
+ *Output: none
+ *Side effect: invalidates the one user video page with invlpg
+ */
+void map_vidmem(uint32_t page){
     kernel_page_directory[VMEM_PDE_INDEX].present = 1;
     kernel_page_directory[VMEM_PDE_INDEX].user= 1;
     kernel_page_directory[VMEM_PDE_INDEX].size = 0; //4KB
@@ -114,9 +341,30 @@ void map_vidmem(){
     pagetable_video[0].present = 1;
     pagetable_video[0].user= 1;
     pagetable_video[0].read_write = 1;
-    pagetable_video[0].page_addr = VIDEO_ADDR;
+    pagetable_video[0].page_addr = page >> 12;
     
-    flush_tlb((int)kernel_page_directory);
+    invlpg(USER_VMEM_ADDR);
+}
+
+/*Function: switch_vidmem ( uint32_t page )
+ *Description: give the process about to run its own user video page: the text
+ *             page of its terminal, or nothing (page 0) if it never called vidmap
+ *Input: page -- address of the text page, 0 to unmap
+ *Output: none
+ *Side effect: invlpg, only when the mapping actually changes
+ */
+void switch_vidmem(uint32_t page){
+    if(page == 0){
+        if(pagetable_video[0].present){
+            pagetable_video[0].present = 0;
+            invlpg(USER_VMEM_ADDR);
+        }
+        return;
+    }
+    if(pagetable_video[0].present && pagetable_video[0].page_addr == (page >> 12)){
+        return;
+    }
+    map_vidmem(page);
 }
 
 void terminal_videopage_init(){
@@ -131,7 +379,7 @@ void terminal_videopage_init(){
     kernel_page_table[t1].accessed           = 0;
     kernel_page_table[t1].dirty              = 0;
     kernel_page_table[t1].reserved           = 0;
-    kernel_page_table[t1].global             = 0;
+    kernel_page_table[t1].global             = 1;
     kernel_page_table[t1].avail              = 0;
     kernel_page_table[t1].page_addr          = (t1);
 
@@ -145,7 +393,7 @@ void terminal_videopage_init(){
     kernel_page_table[t2].accessed           = 0;
     kernel_page_table[t2].dirty              = 0;
     kernel_page_table[t2].reserved           = 0;
-    kernel_page_table[t2].global             = 0;
+    kernel_page_table[t2].global             = 1;
     kernel_page_table[t2].avail              = 0;
     kernel_page_table[t2].page_addr          = (t2);
 
@@ -159,8 +407,22 @@ void terminal_videopage_init(){
     kernel_page_table[t3].accessed           = 0;
     kernel_page_table[t3].dirty              = 0;
     kernel_page_table[t3].reserved           = 0;
-    kernel_page_table[t3].global             = 0;
+    kernel_page_table[t3].global             = 1;
     kernel_page_table[t3].avail              = 0;
     kernel_page_table[t3].page_addr          = t3;
 
+    /* Spare text page the scrollback view is drawn into*/
+    int32_t view = SCROLLBACK_VIEW_ADDR >> 12;
+    kernel_page_table[view].present          = 1;
+    kernel_page_table[view].read_write       = 1;
+    kernel_page_table[view].user             = 0;
+    kernel_page_table[view].write_through    = 0;
+    kernel_page_table[view].cache_disable    = 0;
+    kernel_page_table[view].accessed         = 0;
+    kernel_page_table[view].dirty            = 0;
+    kernel_page_table[view].reserved         = 0;
+    kernel_page_table[view].global           = 1;
+    kernel_page_table[view].avail            = 0;
+    kernel_page_table[view].page_addr        = view;
+
 }
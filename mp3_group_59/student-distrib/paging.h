@@ -6,6 +6,8 @@
 
 #include "types.h"
 #include "lib.h"
+#include "exec_cache.h"
+#include "frame.h"
 
 #define SIZE_4KB 4096
 #define SPACE 1024
@@ -17,6 +19,16 @@
 #define PROGRAM_IMG_PDE_INDEX   32
 #define VMEM_PDE_INDEX          40 // 40*4MB = 160MB
 #define USER_VMEM_ADDR          0x0a000000 // 160MB
+#define MAX_PROCESSES           32         // size of the process table; stacks & page tables come from the frame pool
+#define PROGRAM_IMG_START       0x08048000 // program image virtual address
+#define PROGRAM_IMG_FIRST_PTE   ((PROGRAM_IMG_START - SIZE_128MB) / SIZE_4KB)  // first program page table entry in use
+#define PTE_AVAIL_COW           0x1        // avail bit: page is shared read-only, copy on first write
+#define PTE_AVAIL_DEMAND        0x2        // avail bit: image page not loaded yet, fill on first touch
+#define PTE_AVAIL_ZERO          0x4        // avail bit: no frame yet, give it a zeroed one on first touch
+
+/* page fault error code bits */
+#define PF_ERR_PRESENT          0x1
+#define PF_ERR_WRITE            0x2
 
 typedef struct __attribute__((packed)) page_directory_entry_t{
     uint32_t present            : 1;
@@ -27,7 +39,7 @@ typedef struct __attribute__((packed)) page_directory_entry_t{
     uint32_t accessed           : 1;
     uint32_t reserved           : 1;
     uint32_t size               : 1;      //4MB or 4kB
-    uint32_t ignored            : 1;
+    uint32_t global             : 1;      //G for 4MB pages (ignored for tables)
     uint8_t  avail              : 3;
     uint32_t table_addr         : 20;    //BASE
 }page_directory_entry_t;
@@ -47,6 +59,23 @@ typedef struct __attribute__((packed)) page_table_entry_t{
     uint32_t page_addr          : 20;   //BASE
 }page_table_entry_t;
 
+/* Counters for shared program pages */
+typedef struct paging_stats{
+    uint32_t shared_pages_mapped;       // image pages mapped read-only from the exec cache
+    uint32_t private_pages_mapped;      // zeroed frames handed to bss/heap/stack pages on first touch
+    uint32_t cow_faults;                // write faults that gave a process its own copy
+    uint32_t demand_faults;             // first touches of image pages
+    uint32_t demand_file_reads;         // demand faults filled straight from the file (image not cached)
+} paging_stats_t;
+
+/* What a process's program region was built from (copied so exec cache slots can be reused) */
+typedef struct program_image{
+    exec_cache_entry_t* entry;          // cache entry (only used when image != NULL)
+    uint8_t* image;                     // shared pristine copy, NULL to page in from the file
+    uint32_t inode;
+    uint32_t length;
+} program_image_t;
+
 /* Page directory and page tables */
 page_directory_entry_t kernel_page_directory[1024] __attribute__((aligned(4096)));
 page_table_entry_t kernel_page_table[1024] __attribute__((aligned(4096)));
@@ -58,10 +87,51 @@ extern void paging_init(void);
 //initalize paging for program image
 void execute_paging_init(uint32_t pid);
 
+//build the program page table for a process: image pages demand loaded, rest zero filled
+int32_t program_paging_init(uint32_t pid, exec_cache_entry_t* exe);
+
+//free a process's program page table and private frames
+void program_paging_free(uint32_t pid);
+
+//resolve a page fault in the program region; 0 if handled
+int32_t program_page_fault(uint32_t fault_addr, uint32_t error_code);
+
+//copy out shared page counters
+void paging_get_stats(paging_stats_t* stats);
+
+/* Invalidate the TLB entry for one page */
+static inline void invlpg(uint32_t addr) {
+    asm volatile ("invlpg (%0)"
+            :
+            : "r"(addr)
+            : "memory"
+    );
+}
+
 void flush_tlb(int d);
 
+/* CR4 access (PGE: global pages) */
+#define CR4_PGE                 0x80
+
+static inline uint32_t read_cr4(void) {
+    uint32_t val;
+    asm volatile ("movl %%cr4, %0"
+            : "=r"(val)
+    );
+    return val;
+}
+
+static inline void write_cr4(uint32_t val) {
+    asm volatile ("movl %0, %%cr4"
+            :
+            : "r"(val)
+            : "memory"
+    );
+}
+
 // Initialize paging for video memory
-void map_vidmem();
+void map_vidmem(uint32_t page);
+void switch_vidmem(uint32_t page);
 
 //initialize paging for terminal video memory
 void terminal_videopage_init();
@@ -0,0 +1,46 @@
+/* pit.c - Programmable interval timer: the scheduler's clock
+ * NOTES: channel 0 is run as a PIT_HZ square wave on IRQ0
+ */
+#include "pit.h"
+#include "scheduler.h"
+
+volatile uint32_t pit_ticks;    // ticks since pit_init
+
+/* void pit_init();
+ * Inputs: void
+ * Return Value: none
+ * Function: Programs channel 0 for PIT_HZ and unmasks IRQ0 */
+
+void pit_init(){
+    uint32_t divisor = PIT_BASE_HZ / PIT_HZ;
+    uint32_t flags;
+
+    cli_and_save(flags);
+    pit_ticks = 0;
+    outb(PIT_MODE3_CH0, PIT_COMMAND_PORT);                          // select channel 0, square wave
+    outb(divisor & PIT_LOW_BYTE, PIT_CHANNEL0_PORT);                // low byte of the divisor
+    outb((divisor >> PIT_HIGH_SHIFT) & PIT_LOW_BYTE, PIT_CHANNEL0_PORT); // then the high byte
+    enable_irq(PIT_IRQ);
+    restore_flags(flags);
+}
+
+/* void pit_handler();
+ * Inputs: void
+ * Return Value: none
+ * Function: Counts the tick and hands it to the scheduler. The EOI goes out first
+ *           because sched_tick may not return here until this process runs again. */
+
+void pit_handler(){
+    pit_ticks++;
+    send_eoi(PIT_IRQ);
+    sched_tick();
+}
+
+/* uint32_t pit_get_ticks();
+ * Inputs: void
+ * Return Value: ticks since pit_init (PIT_HZ per second)
+ * Function: Reads the tick counter */
+
+uint32_t pit_get_ticks(){
+    return pit_ticks;
+}
@@ -0,0 +1,24 @@
+/* pit.h - Defines & headers for the 8253/8254 programmable interval timer
+ */
+
+#ifndef _PIT_H
+#define _PIT_H
+
+#include "lib.h"
+#include "i8259.h"
+
+#define PIT_IRQ             0x00
+#define PIT_CHANNEL0_PORT   0x40
+#define PIT_COMMAND_PORT    0x43
+#define PIT_MODE3_CH0       0x36        // channel 0, lobyte/hibyte, square wave
+#define PIT_BASE_HZ         1193182     // input clock of the PIT
+#define PIT_HZ              1000        // one tick per millisecond
+#define PIT_LOW_BYTE        0xFF
+#define PIT_HIGH_SHIFT      8
+
+//function declarations
+void pit_init();
+void pit_handler();
+uint32_t pit_get_ticks();
+
+#endif
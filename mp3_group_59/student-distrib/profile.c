@@ -0,0 +1,233 @@
+/* profile.c - Sampling profiler driven by the PIT tick
+ * NOTES: while running, every tick files the interrupted eip & whether it was
+ *        user code into a ring that keeps the last PROFILE_SAMPLES samples. The
+ *        tick is an ordinary interrupt, so kernel code running with interrupts
+ *        off (system calls, exception handlers) can't be sampled: a tick that
+ *        comes due there is taken where they come back on. For a system call
+ *        that is the program's instruction after the call, which the dispatcher
+ *        leaves in profile_syscall_eip, so such a tick is filed as time in that
+ *        call instead of as user code. profile.sh turns a dump of the ring into
+ *        a flat profile against bootimg's symbols.
+ */
+#include "profile.h"
+
+profile_sample_t profile_samples[PROFILE_SAMPLES];
+uint32_t profile_head;
+volatile uint32_t profile_running;
+uint32_t profile_syscall_eip;
+uint32_t profile_syscall_num;
+
+static int32_t profile_command(const int8_t* buf, int32_t nbytes, const int8_t* cmd);
+static void profile_line(const profile_sample_t* sample, int8_t* line);
+
+/*
+ *   FUNCTION: profile_start
+ *   DESCRIPTION: Starts taking a sample every PIT tick
+ *   INPUTS: none
+ *   OUTPUTS: none
+ *   SIDE EFFECTS: samples are added to what the ring already holds
+ */
+void profile_start(void){
+    profile_running = 1;
+}
+
+/*
+ *   FUNCTION: profile_stop
+ *   DESCRIPTION: Stops sampling, keeping the ring for a dump
+ *   INPUTS: none
+ *   OUTPUTS: none
+ *   SIDE EFFECTS: none
+ */
+void profile_stop(void){
+    profile_running = 0;
+}
+
+/*
+ *   FUNCTION: profile_reset
+ *   DESCRIPTION: Throws away the samples taken so far
+ *   INPUTS: none
+ *   OUTPUTS: none
+ *   SIDE EFFECTS: none
+ */
+void profile_reset(void){
+    uint32_t flags;
+
+    cli_and_save(flags);
+    profile_head = 0;
+    restore_flags(flags);
+}
+
+/*
+ *   FUNCTION: profile_kept
+ *   DESCRIPTION: How many samples the ring holds
+ *   INPUTS: none
+ *   OUTPUTS: samples taken, up to PROFILE_SAMPLES
+ *   SIDE EFFECTS: none
+ */
+uint32_t profile_kept(void){
+    return (profile_head < PROFILE_SAMPLES) ? profile_head : PROFILE_SAMPLES;
+}
+
+/*
+ *   FUNCTION: profile_tick
+ *   DESCRIPTION: Files one sample, if the profiler is running. A tick in user
+ *                code right where the last system call returned to came due
+ *                during that call, so it is filed as the call's
+ *   INPUTS: eip -- where the tick interrupted
+ *           cs -- code segment it interrupted, its low bits give the ring
+ *   OUTPUTS: none
+ *   SIDE EFFECTS: overwrites the oldest sample once the ring is full; uses up
+ *                 profile_syscall_eip, only the first tick there was held off
+ */
+void profile_tick(uint32_t eip, uint32_t cs){
+    profile_sample_t* sample;
+
+    if(!profile_running){
+        return;
+    }
+    sample = &profile_samples[profile_head & PROFILE_SAMPLE_MASK];
+    if((cs & 3) != 3){
+        sample->eip = eip;
+        sample->flags = 0;
+    }
+    else if(eip == profile_syscall_eip){
+        profile_syscall_eip = 0;
+        sample->eip = profile_syscall_num;
+        sample->flags = PROFILE_SYSCALL;
+    }
+    else{
+        sample->eip = eip;
+        sample->flags = PROFILE_USER;
+    }
+    profile_head++;
+}
+
+/*
+ *   FUNCTION: profile_read
+ *   DESCRIPTION: Reads the kept samples like a text file, oldest first; every
+ *                line is PROFILE_LINE_SIZE bytes so the file position says
+ *                which sample comes next
+ *   INPUTS: file_index -- fd of the open profile file
+ *           buf -- where to copy to
+ *           nbytes -- most bytes to copy
+ *   OUTPUTS: bytes copied, 0 at the end of the samples
+ *   SIDE EFFECTS: moves the file position; stop the profiler first for a
+ *                 consistent dump, a running one slides the window along
+ */
+int32_t profile_read(int32_t file_index, void* buf, int32_t nbytes){
+    file_descriptor_t* desc = pcb_obj->fda[file_index];
+    uint32_t kept = profile_kept();
+    uint32_t first = profile_head - kept;
+    uint32_t index, offset, len;
+    int8_t line[PROFILE_LINE_SIZE];
+    int32_t copied = 0;
+
+    if(nbytes < 0){
+        return -1;
+    }
+    while(copied < nbytes && desc->file_position < kept * PROFILE_LINE_SIZE){
+        index = desc->file_position / PROFILE_LINE_SIZE;
+        offset = desc->file_position % PROFILE_LINE_SIZE;
+        profile_line(&profile_samples[(first + index) & PROFILE_SAMPLE_MASK], line);
+
+        len = PROFILE_LINE_SIZE - offset;
+        if(len > nbytes - copied){
+            len = nbytes - copied;
+        }
+        memcpy((int8_t*)buf + copied, line + offset, len);
+        copied += len;
+        desc->file_position += len;
+    }
+    return copied;
+}
+
+/*
+ *   FUNCTION: profile_write
+ *   DESCRIPTION: Takes a command: "start", "stop" or "reset", a trailing newline
+ *                is allowed
+ *   INPUTS: file_index -- fd of the open profile file
+ *           buf -- the command
+ *           nbytes -- its length
+ *   OUTPUTS: nbytes if the command was carried out, -1 otherwise
+ *   SIDE EFFECTS: starts, stops or empties the profiler
+ */
+int32_t profile_write(int32_t file_index, const void* buf, int32_t nbytes){
+    if(profile_command(buf, nbytes, "start")){
+        profile_start();
+    }
+    else if(profile_command(buf, nbytes, "stop")){
+        profile_stop();
+    }
+    else if(profile_command(buf, nbytes, "reset")){
+        profile_reset();
+    }
+    else{
+        return -1;
+    }
+    return nbytes;
+}
+
+/*
+ *   FUNCTION: profile_open
+ *   DESCRIPTION: Nothing to set up, system_open hands out the descriptor
+ *   INPUTS: ignored
+ *   OUTPUTS: 0
+ *   SIDE EFFECTS: none
+ */
+int32_t profile_open(const uint8_t* file_name){
+    return 0;
+}
+
+/*
+ *   FUNCTION: profile_close
+ *   DESCRIPTION: Nothing to tear down, the profiler keeps running
+ *   INPUTS: ignored
+ *   OUTPUTS: 0
+ *   SIDE EFFECTS: none
+ */
+int32_t profile_close(int32_t file_index){
+    return 0;
+}
+
+/*
+ *   FUNCTION: profile_command
+ *   DESCRIPTION: Checks whether a write is a given command
+ *   INPUTS: buf, nbytes -- what was written
+ *           cmd -- command to look for
+ *   OUTPUTS: 1 if buf is cmd, optionally followed by a newline, 0 if not
+ *   SIDE EFFECTS: none
+ */
+static int32_t profile_command(const int8_t* buf, int32_t nbytes, const int8_t* cmd){
+    int32_t len = strlen(cmd);
+
+    if(nbytes == len + 1 && buf[len] == '\n'){
+        nbytes = len;
+    }
+    return nbytes == len && strncmp(buf, cmd, len) == 0;
+}
+
+/*
+ *   FUNCTION: profile_line
+ *   DESCRIPTION: Formats a sample as its profile file line, the eip (or system
+ *                call number) as 8 lowercase hex digits to match nm
+ *   INPUTS: sample -- the sample
+ *           line -- PROFILE_LINE_SIZE bytes to fill
+ *   OUTPUTS: none
+ *   SIDE EFFECTS: none
+ */
+static void profile_line(const profile_sample_t* sample, int8_t* line){
+    static const int8_t hex[] = "0123456789abcdef";
+    int32_t i;
+
+    if(sample->flags & PROFILE_SYSCALL){
+        line[0] = 'S';
+    }
+    else{
+        line[0] = (sample->flags & PROFILE_USER) ? 'U' : 'K';
+    }
+    line[1] = ' ';
+    for(i = 0; i < 8; i++){
+        line[2 + i] = hex[(sample->eip >> (28 - 4 * i)) & 0xF];
+    }
+    line[PROFILE_LINE_SIZE - 1] = '\n';
+}
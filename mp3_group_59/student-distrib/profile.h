@@ -0,0 +1,52 @@
+/* profile.h - Defines & headers for the PIT sampling profiler
+ * NOTES: profile_samples, profile_head & profile_running are global so a debugger
+ *        can pull the ring straight out of a running kernel (see profile.sh)
+ */
+
+#ifndef _PROFILE_H
+#define _PROFILE_H
+
+#include "types.h"
+#include "lib.h"
+#include "filesystem.h"
+
+#define PROFILE_SAMPLES         8192                        // ring size, a power of 2 (8 seconds at PIT_HZ)
+#define PROFILE_SAMPLE_MASK     (PROFILE_SAMPLES - 1)
+#define PROFILE_FILE_NAME       "profile"
+#define PROFILE_FILE_TYPE       6                           // fd file_type of an open profile file
+#define PROFILE_LINE_SIZE       11                          // "K 0040123a\n": ring, eip in hex, newline
+#define PROFILE_USER            1                           // sample flag: interrupted code was in ring 3
+#define PROFILE_SYSCALL         2                           // sample flag: tick held off by a system call, eip is its number
+
+typedef struct profile_sample{
+    uint32_t eip;
+    uint32_t flags;                                         // PROFILE_USER, PROFILE_SYSCALL or 0
+} profile_sample_t;
+
+extern profile_sample_t profile_samples[PROFILE_SAMPLES];
+extern uint32_t profile_head;                               // samples ever taken (free-running)
+extern volatile uint32_t profile_running;
+
+/* set by systemcall_handler.S on the way out of every system call: the user eip
+ * it returns to & its number (0 for a bad one) */
+extern uint32_t profile_syscall_eip;
+extern uint32_t profile_syscall_num;
+
+void profile_start(void);
+void profile_stop(void);
+void profile_reset(void);
+uint32_t profile_kept(void);
+
+/* called by the PIT stub in assembly_linkage.S with the interrupted eip & cs */
+void profile_tick(uint32_t eip, uint32_t cs);
+
+/* the profile pseudo-file: reads give the kept samples oldest first, one
+ * PROFILE_LINE_SIZE line each ('K' kernel or 'U' user then the eip, or 'S'
+ * then the number of the system call the tick was held off by), and
+ * writing "start", "stop" or "reset" controls the sampler */
+int32_t profile_read(int32_t file_index, void* buf, int32_t nbytes);
+int32_t profile_write(int32_t file_index, const void* buf, int32_t nbytes);
+int32_t profile_open(const uint8_t* file_name);
+int32_t profile_close(int32_t file_index);
+
+#endif /* _PROFILE_H */
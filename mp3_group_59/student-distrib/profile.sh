@@ -0,0 +1,108 @@
+#!/bin/bash
+# profile.sh - flat profile of the kernel sampling profiler's samples
+#
+#   ./profile.sh [-u program.exe] samples.txt     samples as printed by "prof dump"
+#   ./profile.sh [-u program.exe] -g [host:port]  pull the ring out of a running
+#                                                 kernel through QEMU's gdb stub
+#                                                 (default localhost:1234)
+#
+# Kernel samples are matched to the nearest symbol at or below them in bootimg;
+# user samples are counted as [user], or matched against program.exe (the
+# unconverted ELF from syscalls/) when -u is given. Kernel code that runs with
+# interrupts off is never sampled: its ticks land on the instruction that turns
+# them back on. The kernel files the ones held off by a system call as "S" with
+# the call's number, counted here as [syscall:name]; the rest of that kernel
+# time (exception handlers) still shows up where it returns to.
+
+BOOTIMG=./bootimg
+USER_EXE=
+GDB_TARGET=
+SAMPLES=
+
+usage() {
+    echo "usage: $0 [-u program.exe] samples.txt | -g [host:port]" >&2
+    exit 1
+}
+
+while [ $# -gt 0 ]; do
+    case "$1" in
+        -u) USER_EXE="$2"; shift 2 || usage ;;
+        -g) GDB_TARGET=localhost:1234; shift
+            case "$1" in ""|-*) ;; *) GDB_TARGET="$1"; shift ;; esac ;;
+        -*) usage ;;
+        *)  SAMPLES="$1"; shift ;;
+    esac
+done
+[ -n "$SAMPLES" ] || [ -n "$GDB_TARGET" ] || usage
+[ -f "$BOOTIMG" ] || { echo "$0: no $BOOTIMG, run make first" >&2; exit 1; }
+
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+export LC_ALL=C
+
+# the ring straight from memory: profile_samples[] holds (eip, flags) pairs (flag
+# 1 user, 2 system call) and profile_head counts every sample ever taken, so the
+# oldest kept one is at profile_head % size once it has wrapped
+if [ -n "$GDB_TARGET" ]; then
+    gdb -batch -nx "$BOOTIMG" \
+        -ex "target remote $GDB_TARGET" \
+        -ex "dump binary memory $TMP/ring.bin &profile_samples[0] &profile_samples[sizeof(profile_samples)/sizeof(profile_samples[0])]" \
+        -ex "printf \"%u\\n\", profile_head" \
+        -ex "detach" 2>/dev/null | tail -n 1 > "$TMP/head"
+    [ -s "$TMP/ring.bin" ] || { echo "$0: could not read the samples from $GDB_TARGET" >&2; exit 1; }
+    SAMPLES="$TMP/samples"
+    od -An -v -t x4 -w8 "$TMP/ring.bin" | awk -v head="$(cat "$TMP/head")" '
+        { eip[NR - 1] = $1; mode[NR - 1] = ($2 % 4 == 2) ? "S" : ($2 % 2) ? "U" : "K" }
+        END {
+            n = NR; kept = (head < n) ? head : n; first = (head < n) ? 0 : head % n
+            for (i = 0; i < kept; i++) {
+                j = (first + i) % n
+                printf "%s %s\n", mode[j], eip[j]
+            }
+        }' > "$SAMPLES"
+fi
+
+# symbolize MODE ELF UNKNOWN: counts the samples of one mode ("K" or "U") under
+# the nearest text symbol of ELF, by sorting the symbols and samples together;
+# samples below every symbol are counted as UNKNOWN
+symbolize() {
+    {
+        nm -n "$2" | awk '$2 ~ /^[TtWw]$/ { print $1, "S", $3 }'
+        awk -v mode="$1" '$1 == mode { print tolower($2), "X" }' "$SAMPLES"
+    } | sort -k1,1 -k2,2 | awk -v unknown="$3" '
+        $2 == "S" { sym = $3; next }
+        { count[sym == "" ? unknown : sym]++ }
+        END { for (s in count) print count[s], s }'
+}
+
+# the system call samples by call number (ece391sysnum.h)
+syscalls() {
+    awk '$1 == "S" { count[$2]++ }
+        END {
+            split("halt execute read write open close getargs vidmap set_handler " \
+                  "sigreturn ioctl readv writev io_enter", name, " ")
+            for (n in count) {
+                num = 0
+                for (i = 1; i <= length(n); i++)
+                    num = num * 16 + index("0123456789abcdef", substr(tolower(n), i, 1)) - 1
+                print count[n], "[syscall:" ((num in name) ? name[num] : num) "]"
+            }
+        }' "$SAMPLES"
+}
+
+{
+    symbolize K "$BOOTIMG" "[kernel?]"
+    syscalls
+    if [ -n "$USER_EXE" ]; then
+        symbolize U "$USER_EXE" "[user?]"
+    else
+        awk '$1 == "U" { n++ } END { if (n) print n, "[user]" }' "$SAMPLES"
+    fi
+} | sort -k1,1nr -k2,2 | awk '
+    { count[NR] = $1; sym[NR] = $2; total += $1 }
+    END {
+        if (total == 0) { print "no samples"; exit }
+        printf "%d samples\n\n  %%time  samples  symbol\n", total
+        for (i = 1; i <= NR; i++)
+            printf "%7.2f %8d  %s\n", 100 * count[i] / total, count[i], sym[i]
+    }'
@@ -7,11 +7,32 @@
 #define SECONDARY_PIC_IRQ 0x02
 #define TOP_4_BITS 0xF0
 #include "rtc.h"
-volatile uint32_t in_count;
+#include "scheduler.h"
+
+volatile uint32_t rtc_hw_ticks;                  // hardware interrupts since rtc_init
+static rtc_timer_t rtc_timers[RTC_MAX_TIMERS];   // one per open rtc file descriptor
+static rtc_timer_t rtc_kernel_timer;             // for kernel callers without a process (tests)
+
+static int32_t rtc_freq_log2(int32_t freq);
+
+/* void rtc_timer_reset(rtc_timer_t* timer, int32_t freq_log2);
+ * Inputs: timer, log2 of the virtual frequency (already validated)
+ * Return Value: none
+ * Function: Restarts the timer's divider; ticks already counted are kept */
+
+static void rtc_timer_reset(rtc_timer_t* timer, int32_t freq_log2){
+    uint32_t flags;
+
+    cli_and_save(flags);
+    timer->divider = RTC_HW_FREQ >> freq_log2;
+    timer->countdown = timer->divider;
+    restore_flags(flags);
+}
+
 /* void rtc_init();
  * Inputs: void
  * Return Value: none
- * Function: Initializes RTC */
+ * Function: Initializes RTC, pinned at RTC_HW_FREQ; readers get virtual rates */
 
 void rtc_init(){
     cli(); //clear interrupt flag (must use sti now at the end)
@@ -24,17 +45,32 @@ void rtc_init(){
     enable_irq(SECONDARY_PIC_IRQ); //enable interrupts for the secondary PIC irq just in case
     sti(); //reset interrupt flag because we used cli();
 
-    //rtc defaults to 1024 hz
+    //rtc defaults to 1024 hz, set it anyway: the virtual timers divide this rate
+    rtc_set_freq(RTC_HW_FREQ);
+    rtc_kernel_timer.in_use = 1;
+    rtc_timer_reset(&rtc_kernel_timer, RTC_DEFAULT_FREQ_LOG2);
 }
 
 void rtc_handler(){
+    int i;
+    rtc_timer_t* timer;
+
     cli(); //clear interrupt flag (must use sti now at the end)
     //test_interrupts();
 
     outb(RTC_REGC, RTC_PORT); //selects register C
     inb(CMOS_PORT); // throws away contents
-    // counter counts up
-    in_count = 1;
+    rtc_hw_ticks++;
+
+    // every virtual timer counts down its own divider
+    for(i = 0; i <= RTC_MAX_TIMERS; i++){
+        timer = (i == RTC_MAX_TIMERS) ? &rtc_kernel_timer : &rtc_timers[i];
+        if(timer->in_use && --timer->countdown == 0){
+            timer->countdown = timer->divider;
+            timer->ticks++;
+            sched_wake(&timer->queue);
+        }
+    }
 
     send_eoi(RTC_IRQ); //sends end-of-line interrupt
     
@@ -42,73 +78,128 @@ void rtc_handler(){
 }
 
 /*
- * rtc_set_freq
- * calculate the frequency index
- *  input: frequency
- *  Returns: index
+ * rtc_timer_alloc
+ * gives a newly opened rtc file descriptor its own virtual timer at RTC_DEFAULT_FREQ
+ *  input: desc -- the rtc file descriptor
+ *  Returns: 0 on success, -1 if every timer is taken
  */
-int32_t rtc_set_freq(int freq){
-    char hex_rate;
+int32_t rtc_timer_alloc(file_descriptor_t* desc){
+    int i;
+    uint32_t flags;
 
-    /*Check to see if the input frequency is divisible by 2*/
-    if( (freq % 2) != 0){
-      printf("Error, input frequency not divisible by 2\n");
-      return -1;
+    cli_and_save(flags);
+    for(i = 0; i < RTC_MAX_TIMERS; i++){
+        if(!rtc_timers[i].in_use){
+            rtc_timers[i].ticks = 0;
+            rtc_timers[i].consumed = 0;
+            rtc_timers[i].queue.head = NULL;
+            rtc_timer_reset(&rtc_timers[i], RTC_DEFAULT_FREQ_LOG2);
+            rtc_timers[i].in_use = 1;
+            desc->rtc_timer = &rtc_timers[i];
+            restore_flags(flags);
+            return 0;
+        }
     }
+    restore_flags(flags);
+    return -1;
+}
 
-    /*Turn the frequency into a hex rate that can be sent to RTC*/
-    if(freq == 2){
-        hex_rate = 0x0F;
-    }
-    else if(freq == 4){
-        hex_rate = 0x0E;
-    }
-    else if(freq == 8){
-        hex_rate = 0x0D;
-    }
-    else if(freq == 16){
-        hex_rate = 0x0C;
-    }
-    else if(freq == 32){
-        hex_rate = 0x0B;
-    }
-    else if(freq == 64){
-        hex_rate = 0x0A;
-    }
-    else if(freq == 128){
-        hex_rate = 0x09;
+/*
+ * rtc_timer_free
+ * releases a closing rtc file descriptor's virtual timer
+ *  input: desc -- the rtc file descriptor
+ *  Returns: none
+ */
+void rtc_timer_free(file_descriptor_t* desc){
+    if(desc->rtc_timer != NULL){
+        desc->rtc_timer->in_use = 0;
+        desc->rtc_timer = NULL;
     }
-    else if(freq == 256){
-        hex_rate = 0x08;
+}
+
+/*
+ * rtc_find_timer
+ * the virtual timer behind a file index of the running process
+ *  input: file_index
+ *  Returns: the descriptor's timer, or the kernel's own one when there is no process
+ */
+static rtc_timer_t* rtc_find_timer(int32_t file_index){
+    if(pcb_obj != NULL && file_index >= 0 && file_index < MAX_OPEN_FILES &&
+       pcb_obj->fda[file_index] != NULL && pcb_obj->fda[file_index]->rtc_timer != NULL){
+        return pcb_obj->fda[file_index]->rtc_timer;
     }
-    else if(freq == 512){
-        hex_rate = 0x07;
+    return &rtc_kernel_timer;
+}
+
+/*
+ * rtc_timer_set_freq
+ * changes one virtual timer's rate; the hardware stays at RTC_HW_FREQ
+ *  input: timer, freq -- a power of 2 from RTC_MIN_FREQ to RTC_HW_FREQ
+ *  Returns: 0 on success, -1 on a bad frequency
+ */
+int32_t rtc_timer_set_freq(rtc_timer_t* timer, int32_t freq){
+    int32_t bit = rtc_freq_log2(freq);
+
+    if(bit < 0){
+        return -1;
     }
-    else if(freq == 1024){
-        hex_rate = 0x06;
+    rtc_timer_reset(timer, bit);
+    return 0;
+}
+
+/*
+ * rtc_freq_log2
+ * validates a frequency and finds its bit index in one step
+ *  input: freq
+ *  Returns: log2(freq) if freq is a power of 2 from RTC_MIN_FREQ to RTC_HW_FREQ, -1 otherwise
+ */
+static int32_t rtc_freq_log2(int32_t freq){
+    int32_t bit;
+
+    if(freq < RTC_MIN_FREQ || freq > RTC_HW_FREQ || (freq & (freq - 1)) != 0){
+        return -1;
     }
-    else {
+    asm ("bsrl %1, %0" : "=r"(bit) : "r"(freq));    // index of the only set bit
+    return bit;
+}
+
+/*
+ * rtc_set_freq
+ * programs the hardware rate (register A) for freq, looked up by its bit index
+ *  input: frequency
+ *  Returns: 0 on success, -1 on a bad frequency (never prints, callers decide)
+ */
+int rtc_set_freq(int freq){
+    /*register A rate for each log2(freq): freq = 32768 >> (rate - 1)*/
+    static const uint8_t rate_by_log2[RTC_HW_FREQ_LOG2 + 1] = {
+        0x00, 0x0F, 0x0E, 0x0D, 0x0C, 0x0B, 0x0A, 0x09, 0x08, 0x07, 0x06
+    };
+    int32_t bit = rtc_freq_log2(freq);
+    uint32_t flags;
+    char prev;
+
+    if(bit < 0){
         return -1;
     }
     
     /*Mask Interrupts*/
-    cli();
+    cli_and_save(flags);
 
     /*Disable NMI*/
     outb(RTC_REGA, RTC_PORT);		
 
     /*Recieve the Initial Value from Reg. A*/
-    char prev = inb(CMOS_PORT);	
+    prev = inb(CMOS_PORT);	
 
     /*Resets index to Register A*/
     outb(RTC_REGA, RTC_PORT);		
 
     /*Writes the rate to Register A*/
-    outb(((prev & TOP_4_BITS) | hex_rate), CMOS_PORT);
+    outb(((prev & TOP_4_BITS) | rate_by_log2[bit]), CMOS_PORT);
     
     /*Re-Enable Interrupts*/
-	  sti();                    
-	  return 1;
+    restore_flags(flags);
+    return 0;
 }
 
 /*
@@ -118,26 +209,30 @@ int32_t rtc_set_freq(int freq){
 *          -1 --failure
 */
 int32_t rtc_write(int32_t file_index, const void *buf, int32_t nbytes){ 
-    int set_freq_return;
+    int32_t freq;
     /*Check if buffer is bull*/
     if (buf == NULL) {   
         printf("Null buffer passed into rtc_write!\n");                   
         return -1;
     }
     
-    set_freq_return = rtc_set_freq(*((int32_t*) buf));  // change frequency but first convert input to int32_t
-    if(set_freq_return != 0){
+    freq = *((int32_t*) buf);  // convert input to int32_t
+
+    /*only this descriptor's virtual rate changes, the hardware stays at RTC_HW_FREQ*/
+    if(rtc_timer_set_freq(rtc_find_timer(file_index), freq) != 0){
         return -1;
     }
-
     return 0;                           // else return success
 }
 
-/* rtc_read: return when rtc interrupt
- * Inputs: none
+/* rtc_read: return at the descriptor's next virtual tick, asleep on its queue until
+ * then. Ticks that came while the reader was busy or preempted are not dropped:
+ * each read consumes one.
+ * Inputs: file_index
  * Outputs: none
  */
 int32_t rtc_read(int32_t file_index, void* buf, int32_t nbytes){
+    rtc_timer_t* timer = rtc_find_timer(file_index);
     
     /*Variable that stores flags*/
     int saved_flags;
@@ -145,15 +240,12 @@ int32_t rtc_read(int32_t file_index, void* buf, int32_t nbytes){
     /*Saves current flags and disables interrupts*/
     cli_and_save(saved_flags);
 
-    in_count = 0; // resets the interrupt flag to low
-    
-    /*Re-enables interrupts*/
-    sti();
-
-    /*Waits until the interrupt flag goes high*/
-    while(in_count == 0){
-
+    /*Sleeps until the timer has a tick we haven't returned (interrupts stay off between checks)*/
+    while(timer->consumed == timer->ticks){
+        sched_sleep(&timer->queue);
     }            
+    timer->consumed++;
+
     /*Restores flags*/  
     restore_flags(saved_flags);
 
@@ -164,30 +256,53 @@ int32_t rtc_read(int32_t file_index, void* buf, int32_t nbytes){
 
 /*
 * rtc_open
-* initializes RTC frequency to 2HZ, return 0
+* sets the kernel's own virtual timer (used when there is no process) to 2HZ, return 0;
+* system_open gives each rtc descriptor its own timer at 2HZ with rtc_timer_alloc
 *  Inputs: const uint8_t* fname -- not used (for file operations table)
 *  Returns: 0 --success
 *          -1 --failure
 */
 int32_t rtc_open(const uint8_t* fname){ 
     /*We want the initial frequency to be 2Hz*/
-    int initial_freq = 2;
-    int open_ret;
-    
-    /*Sets frequency and evaluates return value*/
-    open_ret = rtc_set_freq(initial_freq);
-
-    if (open_ret != 0){
-      printf("RTC Open failure!\n");
-      return -1;
-    }
+    rtc_timer_reset(&rtc_kernel_timer, RTC_DEFAULT_FREQ_LOG2);
+    rtc_kernel_timer.consumed = rtc_kernel_timer.ticks;
     return 0;
 }
 
 /*rtc_close()
 * Inputs: int32_t file_index -- not used (for file operations table)
 * Outputs: none
+* (the descriptor's virtual timer is released by rtc_timer_free)
 */
 int32_t rtc_close(int32_t file_index){
     return 0;
 }
+
+/*rtc_ioctl()
+* sets the descriptor's rate and reads its tick counters in one call, so an
+* animation loop can change speed without a separate write
+* Inputs: int32_t file_index, cmd -- RTC_IOC_RATE_TICKS, arg -- rtc_ioc_t*
+* Outputs: 0 on success, -1 on a bad command, buffer or frequency (the counters are still filled in)
+*/
+int32_t rtc_ioctl(int32_t file_index, int32_t cmd, void* arg){
+    rtc_timer_t* timer = rtc_find_timer(file_index);
+    rtc_ioc_t* req = (rtc_ioc_t*)arg;
+    int32_t ret = 0;
+    uint32_t flags;
+
+    if(cmd != RTC_IOC_RATE_TICKS || req == NULL){
+        return -1;
+    }
+    if(pcb_obj != NULL && bad_userspace_addr(req, sizeof(rtc_ioc_t))){
+        return -1;
+    }
+
+    cli_and_save(flags);
+    if(req->freq != 0){
+        ret = rtc_timer_set_freq(timer, req->freq);
+    }
+    req->ticks = timer->ticks;
+    req->pending = timer->ticks - timer->consumed;
+    restore_flags(flags);
+    return ret;
+}
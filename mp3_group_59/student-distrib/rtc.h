@@ -3,14 +3,46 @@
 
 #include "lib.h"
 #include "i8259.h"
+#include "filesystem.h"
+
+#define RTC_HW_FREQ         1024    // hardware rate, every virtual timer divides it
+#define RTC_HW_FREQ_LOG2    10
+#define RTC_MIN_FREQ        2
+#define RTC_DEFAULT_FREQ    2       // rate of a newly opened rtc
+#define RTC_DEFAULT_FREQ_LOG2   1
+#define RTC_MAX_TIMERS      64      // open rtc file descriptors system-wide
+
+/* Virtual timer behind one open rtc file descriptor */
+typedef struct rtc_timer{
+    uint32_t in_use;
+    uint32_t divider;               // hardware ticks per virtual tick
+    uint32_t countdown;             // hardware ticks left until the next virtual tick
+    uint32_t ticks;                 // virtual ticks since the timer was opened
+    uint32_t consumed;              // virtual ticks already returned by rtc_read
+    wait_queue_t queue;             // rtc_read sleepers
+} rtc_timer_t;
+
+/* rtc ioctl: RTC_IOC_RATE_TICKS sets the rate & reads the counters in one call */
+#define RTC_IOC_RATE_TICKS  1
+typedef struct rtc_ioc{
+    int32_t freq;                   // new virtual rate, 0 keeps the current one
+    uint32_t ticks;                 // out: virtual ticks since open
+    uint32_t pending;               // out: ticks rtc_read hasn't returned yet
+} rtc_ioc_t;
+
+extern volatile uint32_t rtc_hw_ticks;
 
 //function declarations
 void rtc_init();
 void rtc_handler();
 
-/* set the interrupt frequency to freq, by a power of 2 no larger than 1024 */
+/* set the hardware interrupt frequency to freq, a power of 2 no larger than 1024 */
 int rtc_set_freq(int freq);
 
+int32_t rtc_timer_alloc(file_descriptor_t* desc);
+void rtc_timer_free(file_descriptor_t* desc);
+int32_t rtc_timer_set_freq(rtc_timer_t* timer, int32_t freq);
+
 int rtc_write(int32_t file_index, const void *buf, int32_t nbytes);
 
 int32_t rtc_read(int32_t file_index, void* buf, int32_t nbytes);
@@ -19,4 +51,6 @@ int rtc_open();
 
 int32_t rtc_close(int32_t file_index);
 
+int32_t rtc_ioctl(int32_t file_index, int32_t cmd, void* arg);
+
 #endif
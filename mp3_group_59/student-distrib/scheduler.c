@@ -0,0 +1,254 @@
+/* scheduler.c - PIT-driven round-robin scheduler across the terminals
+ * NOTES: each active terminal runs the process on top of its execute chain
+ *        (terminals[].pid). On a switch the outgoing kernel stack is parked in its
+ *        PCB and the incoming process gets its TSS esp0 & program page table back.
+ *        Processes asleep on a wait queue are skipped; with nothing runnable the
+ *        CPU goes back to the kernel's hlt loop until an interrupt wakes someone.
+ */
+#include "scheduler.h"
+
+volatile int32_t sched_terminal = SCHED_IDLE;
+
+static uint32_t sched_timeslice_ticks = SCHED_TIMESLICE_MS * PIT_HZ / MS_PER_SECOND;
+static uint32_t slice_ticks;                    // ticks used of the current slice
+static uint32_t sched_idle_esp;                 // kernel hlt loop, parked while shells run
+static uint32_t sched_dead_esp;                 // parking spot for contexts that never resume
+static uint32_t sched_launch_stack[SCHED_LAUNCH_STACK_WORDS];
+static uint64_t switch_start;
+static sched_stats_t sched_stats;
+
+static void sched_switch(int32_t next, uint32_t* save_esp);
+
+/*
+ *   FUNCTION: sched_init
+ *   DESCRIPTION: Marks every terminal empty, brings up terminal 0 and starts the PIT;
+ *                the first tick launches terminal 0's shell
+ *   INPUTS: none
+ *   OUTPUTS: none
+ *   SIDE EFFECTS: enables IRQ0, the calling context becomes the idle loop
+ */
+void sched_init(){
+    int32_t i;
+
+    for(i = 0; i < NUM_TERMINALS; i++){
+        terminals[i].pid = -1;
+    }
+    pid = -1;
+    parent_pid = -1;
+    sched_terminal = SCHED_IDLE;
+    sched_stats.timeslice_ms = SCHED_TIMESLICE_MS;
+    terminal_init(0);
+    pit_init();
+}
+
+/*
+ *   FUNCTION: sched_set_timeslice
+ *   DESCRIPTION: Changes how many milliseconds each terminal runs before the next one
+ *   INPUTS: ms -- slice length, 1 to SCHED_TIMESLICE_MAX_MS
+ *   OUTPUTS: 0 on success, -1 on a bad length
+ *   SIDE EFFECTS: takes effect from the next tick
+ */
+int32_t sched_set_timeslice(uint32_t ms){
+    if(ms == 0 || ms > SCHED_TIMESLICE_MAX_MS){
+        return -1;
+    }
+    sched_timeslice_ticks = (ms * PIT_HZ + MS_PER_SECOND - 1) / MS_PER_SECOND;
+    sched_stats.timeslice_ms = ms;
+    return 0;
+}
+
+/*
+ *   FUNCTION: get_sched_stats
+ *   DESCRIPTION: Copies out the scheduler counters
+ *   INPUTS: stats -- filled in
+ *   OUTPUTS: none
+ *   SIDE EFFECTS: none
+ */
+void get_sched_stats(sched_stats_t* stats){
+    *stats = sched_stats;
+}
+
+/*
+ *   FUNCTION: sched_pick
+ *   DESCRIPTION: Round robin: the first runnable terminal after the running one
+ *                (active, and its process, if it has one yet, not asleep)
+ *   INPUTS: none
+ *   OUTPUTS: terminal id, or SCHED_IDLE if nothing can run
+ *   SIDE EFFECTS: none
+ */
+static int32_t sched_pick(){
+    int32_t i;
+    int32_t t;
+
+    for(i = 1; i <= NUM_TERMINALS; i++){
+        t = (sched_terminal + i) % NUM_TERMINALS;    // SCHED_IDLE starts the scan at terminal 0
+        if(!terminals[t].active){
+            continue;
+        }
+        if(terminals[t].pid < 0 || !((pcb_t*)find_PCB(terminals[t].pid))->blocked){
+            return t;
+        }
+    }
+    return SCHED_IDLE;
+}
+
+/*
+ *   FUNCTION: sched_launch_shell
+ *   DESCRIPTION: Entry point of the launch stack: executes the base shell of
+ *                sched_terminal. Only returns if the shell could not be started,
+ *                in which case the terminal is given up and the CPU handed back.
+ *   INPUTS: none
+ *   OUTPUTS: none
+ *   SIDE EFFECTS: irets to user mode on success
+ */
+static void sched_launch_shell(){
+    int32_t failed = sched_terminal;
+
+    pid = -1;                               // no parent: execute makes this a base shell
+    parent_pid = -1;
+    sched_stats.launches++;
+    system_execute((uint8_t*)"shell");
+
+    cli();
+    terminals[failed].active = 0;
+    sched_switch(sched_pick(), &sched_dead_esp);
+}
+
+/*
+ *   FUNCTION: sched_switch
+ *   DESCRIPTION: Parks the running context and resumes terminal next: restores
+ *                the globals, TSS esp0, program page table, video page & console
+ *                of its process, or starts its base shell on the launch stack if
+ *                it has none yet
+ *   INPUTS: next -- terminal id or SCHED_IDLE
+ *           save_esp -- where the outgoing kernel stack pointer is kept
+ *   OUTPUTS: none
+ *   SIDE EFFECTS: returns only when the outgoing context is scheduled again
+ */
+static void sched_switch(int32_t next, uint32_t* save_esp){
+    pcb_t* next_pcb;
+    uint32_t* frame;
+
+    switch_start = rdtsc();
+    sched_stats.switches++;
+    irq_switch_epoch++;                                 // interrupt handlers on this stack stop being timed
+    sched_terminal = next;
+
+    if(next == SCHED_IDLE){
+        pid = -1;
+        parent_pid = -1;
+        pcb_obj = NULL;
+        execute_paging_init(0);
+        console_select(curr_terminal_id);
+        context_switch(save_esp, sched_idle_esp);
+    }
+    else if(terminals[next].pid < 0){
+        /* context_switch pops edi, esi, ebx, ebp & returns into sched_launch_shell */
+        frame = &sched_launch_stack[SCHED_LAUNCH_STACK_WORDS];
+        *(--frame) = 0;                                 // sched_launch_shell never returns
+        *(--frame) = (uint32_t)sched_launch_shell;
+        *(--frame) = 0;                                 // ebp
+        *(--frame) = 0;                                 // ebx
+        *(--frame) = 0;                                 // esi
+        *(--frame) = 0;                                 // edi
+        console_select(next);
+        context_switch(save_esp, (uint32_t)frame);
+    }
+    else{
+        next_pcb = (pcb_t*)find_PCB(terminals[next].pid);
+        pid = next_pcb->pcb_pid;
+        parent_pid = next_pcb->parent_pid;
+        pcb_obj = next_pcb;
+        tss.ss0 = KERNEL_DS;
+        tss.esp0 = next_pcb->tss_esp0;
+        execute_paging_init(pid + 1);
+        switch_vidmem(next_pcb->vidmap ? terminals[next].video_mem_addr : 0);
+        console_select(next);                           // its printing goes to its own terminal's page
+        context_switch(save_esp, next_pcb->sched_esp);
+    }
+
+    /* back on our own stack: whoever switched to us started the clock */
+    sched_stats.last_switch_cycles = (uint32_t)(rdtsc() - switch_start);
+    sched_stats.total_switch_cycles += sched_stats.last_switch_cycles;
+}
+
+/*
+ *   FUNCTION: sched_tick
+ *   DESCRIPTION: PIT tick (EOI already sent): once the slice is used up, switch to
+ *                the next active terminal
+ *   INPUTS: none
+ *   OUTPUTS: none
+ *   SIDE EFFECTS: may run other processes before returning
+ */
+void sched_tick(){
+    int32_t next;
+    uint32_t* save_esp;
+
+    sched_stats.ticks++;
+    if(sched_terminal == SCHED_IDLE){
+        sched_stats.idle_ticks++;           // the idle loop looks for work every tick
+    }
+    else{
+        sched_stats.busy_ticks++;
+        if(++slice_ticks < sched_timeslice_ticks){
+            return;
+        }
+    }
+    slice_ticks = 0;
+
+    next = sched_pick();
+    if(next == sched_terminal){
+        return;
+    }
+    save_esp = (sched_terminal == SCHED_IDLE) ? &sched_idle_esp : &pcb_obj->sched_esp;
+    sched_switch(next, save_esp);
+}
+
+/*
+ *   FUNCTION: sched_sleep
+ *   DESCRIPTION: Blocks the running process on queue and gives the CPU away until
+ *                sched_wake. Call with interrupts off after checking the condition
+ *                (so a wakeup can't slip in between) and check it again on return.
+ *                Before the first shell there is no process to block, so the
+ *                caller just halts until the next interrupt.
+ *   INPUTS: queue -- wait queue to sleep on
+ *   OUTPUTS: none
+ *   SIDE EFFECTS: returns with interrupts off
+ */
+void sched_sleep(wait_queue_t* queue){
+    pcb_t* self;
+
+    if(sched_terminal == SCHED_IDLE){
+        asm volatile("sti; hlt; cli" : : : "memory");
+        return;
+    }
+    self = pcb_obj;
+    self->blocked = 1;
+    self->wait_next = queue->head;
+    queue->head = self;
+    sched_stats.sleeps++;
+
+    slice_ticks = 0;
+    sched_switch(sched_pick(), &self->sched_esp);
+}
+
+/*
+ *   FUNCTION: sched_wake
+ *   DESCRIPTION: Makes every process asleep on queue runnable again; they get the
+ *                CPU at their next turn (the idle loop checks every tick)
+ *   INPUTS: queue -- wait queue to empty
+ *   OUTPUTS: none
+ *   SIDE EFFECTS: safe from interrupt handlers
+ */
+void sched_wake(wait_queue_t* queue){
+    pcb_t* p;
+    uint32_t flags;
+
+    cli_and_save(flags);
+    for(p = queue->head; p != NULL; p = p->wait_next){
+        p->blocked = 0;
+        sched_stats.wakeups++;
+    }
+    queue->head = NULL;
+    restore_flags(flags);
+}
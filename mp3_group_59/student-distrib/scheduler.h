@@ -0,0 +1,49 @@
+/* scheduler.h - Defines & headers for the PIT-driven round-robin scheduler
+ * NOTES: one process runs per terminal (the top of that terminal's execute chain);
+ *        the PIT rotates between the active terminals every time slice
+ */
+
+#ifndef _SCHEDULER_H
+#define _SCHEDULER_H
+
+#include "types.h"
+#include "lib.h"
+#include "pit.h"
+#include "syscall.h"
+#include "terminal_driver.h"
+
+#define SCHED_TIMESLICE_MS          10      // default time slice
+#define SCHED_TIMESLICE_MAX_MS      1000
+#define SCHED_IDLE                  -1      // no terminal running: the kernel's hlt loop
+#define SCHED_LAUNCH_STACK_WORDS    2048    // 8KB, base shells are executed from here
+#define MS_PER_SECOND               1000
+
+/* Scheduler counters */
+typedef struct sched_stats{
+    uint32_t ticks;
+    uint32_t switches;
+    uint32_t launches;              // base shells started by the scheduler
+    uint32_t timeslice_ms;
+    uint32_t idle_ticks;            // ticks spent in the hlt loop
+    uint32_t busy_ticks;            // ticks with a process on the CPU
+    uint32_t sleeps;
+    uint32_t wakeups;
+    uint32_t last_switch_cycles;    // sched_switch entry until the next context is back on its stack
+    uint64_t total_switch_cycles;
+} sched_stats_t;
+
+/* terminal whose process is on the CPU (SCHED_IDLE before the first shell) */
+extern volatile int32_t sched_terminal;
+
+/* stack switch (context_switch.S): parks the current kernel stack in *save_esp and
+   resumes the one at new_esp where its own context_switch call left off */
+extern void context_switch(uint32_t* save_esp, uint32_t new_esp);
+
+void sched_init();
+void sched_tick();
+void sched_sleep(wait_queue_t* queue);
+void sched_wake(wait_queue_t* queue);
+int32_t sched_set_timeslice(uint32_t ms);
+void get_sched_stats(sched_stats_t* stats);
+
+#endif
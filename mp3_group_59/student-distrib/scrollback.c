@@ -0,0 +1,182 @@
+/* scrollback.c - Per-terminal history of the rows scrolled off the screen
+ * NOTES: a row is stored as its characters (trailing blanks dropped) and its
+ *        attributes as (length, attribute) runs, so an ordinary 20 character
+ *        line costs 24 bytes instead of 160. Viewing draws the history into a
+ *        spare text page and points the VGA start address at it; the live page
+ *        keeps taking output underneath and is shown again by moving it back.
+ */
+#include "scrollback.h"
+
+/*
+ *   FUNCTION: scrollback_init
+ *   DESCRIPTION: Empties a terminal's history
+ *   INPUTS: sb -- history to empty
+ *   OUTPUTS: none
+ *   SIDE EFFECTS: none
+ */
+void scrollback_init(scrollback_t* sb){
+    sb->head = 0;
+    sb->first = 0;
+    sb->last = 0;
+    sb->view = 0;
+}
+
+/*
+ *   FUNCTION: scrollback_push
+ *   DESCRIPTION: Encodes a row that is about to scroll off the screen and appends
+ *                it, dropping the oldest lines until it fits
+ *   INPUTS: sb -- terminal history
+ *           row -- NUM_COLS character/attribute words
+ *   OUTPUTS: none
+ *   SIDE EFFECTS: a scrolled-back view stays on the same text
+ */
+void scrollback_push(scrollback_t* sb, const uint16_t* row){
+    uint8_t line[SCROLLBACK_LINE_MAX];
+    uint32_t chars, runs, len, i, pos;
+    uint8_t attr;
+
+    chars = NUM_COLS;
+    while(chars > 0 && row[chars - 1] == SCROLLBACK_BLANK){
+        chars--;
+    }
+
+    /* characters first, then the attribute runs after them */
+    pos = SCROLLBACK_LINE_HEADER;
+    for(i = 0; i < chars; i++){
+        line[pos++] = (uint8_t)row[i];
+    }
+    runs = 0;
+    for(i = 0; i < chars; i += len){
+        attr = (uint8_t)(row[i] >> 8);
+        for(len = 1; i + len < chars && (uint8_t)(row[i + len] >> 8) == attr; len++);
+        line[pos++] = (uint8_t)len;
+        line[pos++] = attr;
+        runs++;
+    }
+    line[0] = (uint8_t)chars;
+    line[1] = (uint8_t)runs;
+
+    /* make room */
+    while(sb->last - sb->first == SCROLLBACK_LINES ||
+          (sb->first != sb->last && sb->head + pos - sb->line_start[sb->first & SCROLLBACK_LINE_MASK] > SCROLLBACK_BYTES)){
+        sb->first++;
+    }
+
+    sb->line_start[sb->last & SCROLLBACK_LINE_MASK] = sb->head;
+    for(i = 0; i < pos; i++){
+        sb->data[(sb->head + i) & SCROLLBACK_BYTE_MASK] = line[i];
+    }
+    sb->head += pos;
+    sb->last++;
+
+    if(sb->view != 0 && sb->view < sb->last - sb->first){
+        sb->view++;
+    }
+}
+
+/*
+ *   FUNCTION: scrollback_line
+ *   DESCRIPTION: Decodes one line of the history back into a screen row
+ *   INPUTS: sb -- terminal history
+ *           line -- 0 for the oldest line kept
+ *           row -- NUM_COLS words to fill
+ *   OUTPUTS: bytes the line took in the history, -1 if there is no such line
+ *   SIDE EFFECTS: none
+ */
+int32_t scrollback_line(scrollback_t* sb, uint32_t line, uint16_t* row){
+    uint32_t start, pos, chars, runs, len, i, c;
+    uint16_t attr;
+
+    if(line >= sb->last - sb->first){
+        return -1;
+    }
+    start = sb->line_start[(sb->first + line) & SCROLLBACK_LINE_MASK];
+    pos = start;
+    chars = sb->data[pos & SCROLLBACK_BYTE_MASK];
+    runs = sb->data[(pos + 1) & SCROLLBACK_BYTE_MASK];
+    pos += SCROLLBACK_LINE_HEADER;
+
+    for(i = 0; i < chars; i++){
+        row[i] = sb->data[(pos + i) & SCROLLBACK_BYTE_MASK];
+    }
+    pos += chars;
+    for(c = 0; runs > 0; runs--){
+        len = sb->data[pos & SCROLLBACK_BYTE_MASK];
+        attr = sb->data[(pos + 1) & SCROLLBACK_BYTE_MASK] << 8;
+        pos += 2;
+        for(i = 0; i < len; i++){
+            row[c++] |= attr;
+        }
+    }
+    for(i = chars; i < NUM_COLS; i++){
+        row[i] = SCROLLBACK_BLANK;
+    }
+    return pos - start;
+}
+
+/*
+ *   FUNCTION: scrollback_render
+ *   DESCRIPTION: Draws the screen as it looked sb->view lines back: history on top,
+ *                the top rows of the live screen underneath
+ *   INPUTS: sb -- terminal history
+ *           live -- the terminal's live text page
+ *           screen -- NUM_ROWS * NUM_COLS words to draw into
+ *   OUTPUTS: none
+ *   SIDE EFFECTS: none
+ */
+void scrollback_render(scrollback_t* sb, const uint16_t* live, uint16_t* screen){
+    uint32_t count = sb->last - sb->first;
+    uint32_t r, line;
+
+    for(r = 0; r < NUM_ROWS; r++){
+        line = count - sb->view + r;
+        if(line < count){
+            scrollback_line(sb, line, screen + r * NUM_COLS);
+        }
+        else{
+            memcpy(screen + r * NUM_COLS, live + (line - count) * NUM_COLS, NUM_COLS * sizeof(uint16_t));
+        }
+    }
+}
+
+/*
+ *   FUNCTION: scrollback_scroll
+ *   DESCRIPTION: Moves the view back (lines > 0) or forward through the history,
+ *                showing the live page again once it reaches the bottom
+ *   INPUTS: sb -- history of the terminal on screen
+ *           lines -- how far to move, positive is further back
+ *           live_addr -- the terminal's live text page
+ *   OUTPUTS: lines now scrolled back
+ *   SIDE EFFECTS: redraws the view page and moves the VGA start address
+ */
+int32_t scrollback_scroll(scrollback_t* sb, int32_t lines, uint32_t live_addr){
+    int32_t view = (int32_t)sb->view + lines;
+    int32_t count = (int32_t)(sb->last - sb->first);
+
+    if(view > count){
+        view = count;
+    }
+    if(view <= 0){
+        scrollback_reset(sb, live_addr);
+        return 0;
+    }
+    sb->view = view;
+    scrollback_render(sb, (const uint16_t*)live_addr, (uint16_t*)SCROLLBACK_VIEW_ADDR);
+    set_display_start(SCROLLBACK_VIEW_ADDR);
+    return view;
+}
+
+/*
+ *   FUNCTION: scrollback_reset
+ *   DESCRIPTION: Leaves the history view, if it is up
+ *   INPUTS: sb -- history of the terminal on screen
+ *           live_addr -- the terminal's live text page
+ *   OUTPUTS: none
+ *   SIDE EFFECTS: moves the VGA start address back to the live page
+ */
+void scrollback_reset(scrollback_t* sb, uint32_t live_addr){
+    if(sb->view != 0){
+        sb->view = 0;
+        set_display_start(live_addr);
+    }
+}
@@ -0,0 +1,44 @@
+/* scrollback.h - Defines & headers for the per-terminal scrollback history
+ * NOTES: rows that scroll off the top of a terminal are kept here, packed as
+ *        their characters plus run-length encoded attributes
+ */
+
+#ifndef _SCROLLBACK_H
+#define _SCROLLBACK_H
+
+#include "types.h"
+#include "lib.h"
+
+#define SCROLLBACK_LINES            256                         // lines kept, a power of 2 (over 10 screens)
+#define SCROLLBACK_LINE_MASK        (SCROLLBACK_LINES - 1)
+#define SCROLLBACK_BYTES            8192                        // encoded history per terminal, a power of 2
+#define SCROLLBACK_BYTE_MASK        (SCROLLBACK_BYTES - 1)
+#define SCROLLBACK_LINE_HEADER      2                           // character count, attribute run count
+#define SCROLLBACK_LINE_MAX         (SCROLLBACK_LINE_HEADER + 3 * NUM_COLS)
+#define SCROLLBACK_PAGE             (NUM_ROWS - 1)              // Shift+PgUp/PgDn step, keeps a row of context
+#define SCROLLBACK_VIEW_ADDR        0xBC000                     // spare VGA text page the history is drawn into
+#define SCROLLBACK_BLANK            ((0x7 << 8) | ' ')          // what an empty cell holds
+
+/* Encoded lines live in a byte ring; line_start[] holds each line's free-running
+ * offset into it, indexed by line number. A line is
+ *   [chars][runs] chars[chars] (run length, attribute)[runs]
+ * with trailing blanks dropped.
+ *   [first, last)  line numbers still in the history
+ *   view           how many lines the screen is scrolled back, 0 when live */
+typedef struct scrollback{
+    uint8_t data[SCROLLBACK_BYTES];
+    uint32_t line_start[SCROLLBACK_LINES];
+    uint32_t head;                  // next free byte (free-running)
+    uint32_t first;
+    uint32_t last;
+    uint32_t view;
+} scrollback_t;
+
+void scrollback_init(scrollback_t* sb);
+void scrollback_push(scrollback_t* sb, const uint16_t* row);
+int32_t scrollback_line(scrollback_t* sb, uint32_t line, uint16_t* row);
+void scrollback_render(scrollback_t* sb, const uint16_t* live, uint16_t* screen);
+int32_t scrollback_scroll(scrollback_t* sb, int32_t lines, uint32_t live_addr);
+void scrollback_reset(scrollback_t* sb, uint32_t live_addr);
+
+#endif
@@ -0,0 +1,113 @@
+/* slab.c - Slab allocator for fixed size kernel objects
+ * Functions: slab_init, slab_cache_init, slab_alloc, slab_free
+ * NOTES:
+ *      - a free object's first word points at the next free object
+ *      - a cache takes one more frame (and threads it onto its free list) only when
+ *        the list runs dry; frames are never given back, so freed objects are reused
+ *        without fragmenting the frame pool
+ */
+
+#include "slab.h"
+#include "filesystem.h"
+
+#define SLAB_ALIGN      4
+
+slab_cache_t pcb_cache;
+slab_cache_t fd_cache;
+slab_cache_t io_buf_cache;
+
+/*
+*   FUNCTION: slab_init
+*   DESCRIPTION: Sets up the kernel's object caches (no frames are taken yet)
+*   INPUTS: none
+*   OUTPUTS: none
+*/
+void slab_init(void){
+    slab_cache_init(&pcb_cache, (int8_t*)"pcb", sizeof(pcb_t));
+    slab_cache_init(&fd_cache, (int8_t*)"fd", sizeof(file_descriptor_t));
+    slab_cache_init(&io_buf_cache, (int8_t*)"io_buf", SLAB_IO_BUF_SIZE);
+}
+
+/*
+*   FUNCTION: slab_cache_init
+*   DESCRIPTION: Empties a cache and sets the size of its objects
+*   INPUTS: slab_cache_t* cache -- cache to set up
+*           const int8_t* name -- name for stats output
+*           uint32_t object_size -- bytes per object (at most a frame)
+*   OUTPUTS: none
+*   SIDE EFFECTS: forgets any frames the cache had
+*/
+void slab_cache_init(slab_cache_t* cache, const int8_t* name, uint32_t object_size){
+    memset(cache, 0, sizeof(slab_cache_t));
+    cache->name = name;
+    if(object_size < sizeof(void*)){
+        object_size = sizeof(void*);
+    }
+    cache->object_size = (object_size + SLAB_ALIGN - 1) & ~(SLAB_ALIGN - 1);
+    cache->objects_per_slab = FRAME_SIZE / cache->object_size;
+}
+
+/*
+*   FUNCTION: slab_grow
+*   DESCRIPTION: Carves a fresh frame into objects and puts them on the free list
+*   INPUTS: slab_cache_t* cache -- cache with an empty free list
+*   OUTPUTS: 0 on success, -1 if the frame pool is empty
+*/
+static int32_t slab_grow(slab_cache_t* cache){
+    uint32_t frame = frame_alloc();
+    uint8_t* object;
+    uint32_t i;
+
+    if(frame == FRAME_NONE || cache->objects_per_slab == 0){
+        return -1;
+    }
+    object = (uint8_t*)frame;                                   // frames are identity mapped
+    for(i = 0; i < cache->objects_per_slab; i++){
+        *(void**)object = cache->free_list;
+        cache->free_list = object;
+        object += cache->object_size;
+    }
+    cache->slabs++;
+    return 0;
+}
+
+/*
+*   FUNCTION: slab_alloc
+*   DESCRIPTION: Hands out one object from a cache
+*   INPUTS: slab_cache_t* cache -- cache to allocate from
+*   OUTPUTS: the object (contents undefined), NULL if no frame could back it
+*/
+void* slab_alloc(slab_cache_t* cache){
+    void* object;
+
+    if(cache->free_list == NULL && slab_grow(cache) != 0){
+        cache->failures++;
+        return NULL;
+    }
+    object = cache->free_list;
+    cache->free_list = *(void**)object;
+
+    cache->allocations++;
+    cache->in_use++;
+    if(cache->in_use > cache->high_water){
+        cache->high_water = cache->in_use;
+    }
+    return object;
+}
+
+/*
+*   FUNCTION: slab_free
+*   DESCRIPTION: Gives an object back to its cache
+*   INPUTS: slab_cache_t* cache -- cache the object came from
+*           void* object -- object from slab_alloc (NULL is ignored)
+*   OUTPUTS: none
+*/
+void slab_free(slab_cache_t* cache, void* object){
+    if(object == NULL){
+        return;
+    }
+    *(void**)object = cache->free_list;
+    cache->free_list = object;
+    cache->frees++;
+    cache->in_use--;
+}
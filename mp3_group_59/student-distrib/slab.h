@@ -0,0 +1,42 @@
+/* slab.h - Defines & headers for the kernel slab allocator
+ * NOTES:
+ *      - each cache hands out objects of one size carved from 4KB frames (frame.c)
+ *      - free objects are kept on a list threaded through the objects themselves, so
+ *        allocate & free are O(1); frames stay with their cache once taken
+ */
+
+#ifndef _SLAB_H
+#define _SLAB_H
+
+#include "types.h"
+#include "lib.h"
+#include "frame.h"
+
+#define SLAB_IO_BUF_SIZE        128                             // size of an io_buf_cache buffer (a command line)
+
+/* Slab Cache: free list & counters for one object type */
+typedef struct slab_cache{
+    const int8_t* name;
+    uint32_t object_size;                                       // rounded up to a multiple of 4
+    uint32_t objects_per_slab;                                  // objects carved from each frame
+    void* free_list;                                            // first free object, NULL if none
+    uint32_t slabs;                                             // frames taken from the frame pool
+    uint32_t allocations;
+    uint32_t frees;
+    uint32_t in_use;
+    uint32_t high_water;                                        // most objects ever in use at once
+    uint32_t failures;                                          // allocations the frame pool could not back
+} slab_cache_t;
+
+/* Kernel Object Caches */
+extern slab_cache_t pcb_cache;                                  // pcb_t
+extern slab_cache_t fd_cache;                                   // file_descriptor_t
+extern slab_cache_t io_buf_cache;                               // SLAB_IO_BUF_SIZE byte buffers
+
+/* Functions to Manage Slab Caches */
+void slab_init(void);
+void slab_cache_init(slab_cache_t* cache, const int8_t* name, uint32_t object_size);
+void* slab_alloc(slab_cache_t* cache);
+void slab_free(slab_cache_t* cache, void* object);
+
+#endif /* _SLAB_H */
@@ -7,32 +7,66 @@
     *         system_close(int32_t fd)
     *       system_getargs(uint8_t* buf, int32_t nbytes)
     *    system_vidmap(uint8_t** screen_start)
+    *     system_ioctl(int32_t fd, int32_t cmd, void* arg)
+    *     system_readv(int32_t fd, const iovec_t* iov, int32_t iovcnt)
+    *     system_writev(int32_t fd, const iovec_t* iov, int32_t iovcnt)
+    *     system_io_enter(io_ring_t* ring)
     * file_operations_initialize(void)
     * find_PCB(int32_t pid)
     * assign_PID()
+    * release_PID(int32_t pid)
+    * kernel_stack_alloc(int32_t pid)
+    * kernel_stack_free(int32_t pid)
+    * kernel_stack_top(int32_t pid)
     * 
  */
 
 #include "syscall.h"
-
-/*Magic Bytes for bytes 0-3 in file*/
-#define MAGIC_BYTE_0    0x7f 
-#define MAGIC_BYTE_1    0x45 
-#define MAGIC_BYTE_2    0x4c
-#define MAGIC_BYTE_3    0x46
-#define BYTES_TO_CMPR   4  
+#include "scheduler.h"
 
 /*Numerical Constants*/
-#define MAX_PROCESSES       5 //max number of processes (as told by TA)
-#define END_OF_KERNEL_PAGE  0x800000 //8MB
 #define KERNEL_STACK_SIZE   0x2000 //8kB
+#define KERNEL_STACK_FRAMES (KERNEL_STACK_SIZE / FRAME_SIZE)
 
 
 
 /*global variables*/
 int32_t pid; //keeps track of current process ID
 int32_t parent_pid; //keeps track of parent process ID
+static execute_stats_t execute_stats; //launch latency counters
+
+/*PID allocator: stack of free pids, popped by assign_PID and pushed by release_PID*/
+static int32_t pid_free_stack[MAX_PROCESSES];
+static int32_t pid_free_top; //number of free pids on the stack
+static uint8_t pid_in_use[MAX_PROCESSES];
+static pid_stats_t pid_stats;
+
+/*process table: each pid's 8KB kernel stack from the frame pool (0 if none) and its PCB from pcb_cache*/
+static uint32_t kernel_stacks[MAX_PROCESSES];
+static pcb_t* pcbs[MAX_PROCESSES];
+static uint32_t sysenter_stack[SYSENTER_STACK_WORDS];  //only held until sysenter_handler loads tss.esp0
+
+static file_descriptor_t* fd_alloc(file_operations_table_t* fop, uint32_t inode, uint32_t type);
+static void fd_close_all(pcb_t* pcb);
+
 
+/*Function Name: sysenter_init(void)
+    * Description: Points the SYSENTER MSRs at the kernel code segment, a scratch stack
+    *              & sysenter_handler, next to the int $0x80 gate old programs still use
+    * Inputs: none
+    * Outputs: 0 if the fast path is on, -1 if the CPU has no SYSENTER
+    * Side Effects: the GDT must keep KERNEL_DS, USER_CS & USER_DS right after KERNEL_CS
+    *               (SYSENTER/SYSEXIT derive ss and the user selectors from it)
+*/
+int32_t sysenter_init(void){
+    if(!(cpuid_features() & CPUID_SEP)){
+        return -1;
+    }
+    wrmsr(IA32_SYSENTER_CS, KERNEL_CS, 0);
+    wrmsr(IA32_SYSENTER_ESP, (uint32_t)&sysenter_stack[SYSENTER_STACK_WORDS], 0);
+    wrmsr(IA32_SYSENTER_EIP, (uint32_t)sysenter_handler, 0);
+    return 0;
+}
 
 /*Function Name: file_operations_initialize(void)
     * Description: Initializes the file operations table
@@ -46,36 +80,63 @@ void file_operations_initialize(void){
     null.write = no_operation_write;    
     null.open = no_operation_open;
     null.close = no_operation_close;
+    null.ioctl = no_operation_ioctl;
 
     // file_operations_table_t stdin;          // terminal
     stdin.read = terminal_read;
     stdin.write = no_operation_write;              // just reads from terminal
     stdin.open = terminal_open;
     stdin.close = terminal_close;
+    stdin.ioctl = no_operation_ioctl;
 
     // file_operations_table_t stdout;
     stdout.read = no_operation_read;
     stdout.write = terminal_write;  
     stdout.open = terminal_open;
     stdout.close = terminal_close;
+    stdout.ioctl = no_operation_ioctl;
 
     // file_operations_table_t rtc; 
     rtc.read = rtc_read;    
     rtc.write = rtc_write;
     rtc.open = rtc_open;
     rtc.close = rtc_close;
+    rtc.ioctl = rtc_ioctl;
 
     // file_operations_table_t files;
     files.read = file_read;
     files.write = file_write;
     files.open = file_open;
     files.close = file_close;
+    files.ioctl = no_operation_ioctl;
 
     // file_operations_table_t directories;
     directories.read = directory_read;
     directories.write = directory_write;
     directories.open = directory_open;
     directories.close = directory_close;
+    directories.ioctl = no_operation_ioctl;
+
+    // file_operations_table_t stats;
+    stats.read = stats_read;
+    stats.write = stats_write;
+    stats.open = stats_open;
+    stats.close = stats_close;
+    stats.ioctl = no_operation_ioctl;
+
+    // file_operations_table_t irqstats;
+    irqstats.read = irqstats_read;
+    irqstats.write = stats_write;
+    irqstats.open = stats_open;
+    irqstats.close = stats_close;
+    irqstats.ioctl = no_operation_ioctl;
+
+    // file_operations_table_t profile;
+    profile.read = profile_read;
+    profile.write = profile_write;
+    profile.open = profile_open;
+    profile.close = profile_close;
+    profile.ioctl = no_operation_ioctl;
 
 }
 
@@ -88,11 +149,11 @@ void file_operations_initialize(void){
  1. Parses command from string
  2. Separates command from arguments
  3. Searches filesystem for file name corresponding to program
- 4. Reads starting bits of program image in order to determine if it's an executable
+ 4. Looks the program up in the exec cache to determine if it's an executable
  5. Assigns pid to process and keeps track of the number of active processes
  6. Initializes a PCB struct for the process
- 7. Sets up paging for the program image
- 8. Copies program image to virtual memory address
+ 7. Sets up paging for the program image (cached images are shared copy-on-write)
+ 8. Leaves the image to be demand loaded by the page fault handler
  9. Saves relevant info to PCB, edits TSS
  10. Pushes required values into stack, executes IRET to perform context switch
 
@@ -104,6 +165,7 @@ void file_operations_initialize(void){
  */
 
 int32_t system_execute(const uint8_t* command){
+    uint64_t launch_start = rdtsc(); // launch latency is measured up to the iret
     int ret_val; // value to be returned by function
     int i;
     int32_t parent_pid = pid; // gets global pid value and puts it in this var before its overwritten
@@ -118,8 +180,13 @@ int32_t system_execute(const uint8_t* command){
     if (cmd_strlen > NUM_CHARS_KB){                             // command length too long
         return -1;
     }
-    uint8_t fname[NUM_CHARS_KB];
-    uint8_t args[NUM_CHARS_KB];
+    uint8_t* fname = (uint8_t*)slab_alloc(&io_buf_cache);
+    uint8_t* args = (uint8_t*)slab_alloc(&io_buf_cache);
+    if (fname == NULL || args == NULL){
+        slab_free(&io_buf_cache, fname);
+        slab_free(&io_buf_cache, args);
+        return -1;
+    }
 
     /*Initilize the filname buffer and args buffer with \0*/
     for (i = 0;  i < NUM_CHARS_KB ; i++){
@@ -159,92 +226,91 @@ int32_t system_execute(const uint8_t* command){
 
     dentry_t dentry; // pointer to empty dentry to be passed into read_dentry_by_name ::TODO:: may need to be changed to regular struct
     int32_t file_search_ret = read_dentry_by_name(fname, &dentry);
+    slab_free(&io_buf_cache, fname);
     if (file_search_ret != 0){ //if the file was not found
         // printf("File Search Error!\n");
+        slab_free(&io_buf_cache, args);
         return -1;
     }
     
-    /*see if the file is executable (compare magic numbers in first 4 bytes of file)*/
+    /*see if the file is executable (ELF magic checked once per file by the exec cache)*/
 
     uint32_t file_inode = dentry.inode_num; //extract inode index from dentry
-    uint32_t file_length = inodes[file_inode].length;
-    uint32_t file_offset = 0; //we want to read from the start of the file
-    uint8_t file_bytes[BYTES_TO_CMPR]; //initialize empty buffer for file data
-    
-    int32_t elf_read_ret = read_data(file_inode, file_offset, file_bytes, BYTES_TO_CMPR); 
-    if (elf_read_ret != BYTES_TO_CMPR){ //if the number of bytes copied doesn't match
-        // printf("File Read Error! Bytes didn't match \n");
+    exec_cache_entry_t* exec_entry; //validated image & entry point for the file
+    if (exec_cache_lookup(file_inode, &exec_entry) != 0){ //if the file is not an executable
+        // printf("File Read Error! Execute bytes don't match \n");
+        slab_free(&io_buf_cache, args);
         return -1;
     }
 
-    uint8_t execute_bytes[BYTES_TO_CMPR] = {MAGIC_BYTE_0, MAGIC_BYTE_1, MAGIC_BYTE_2, MAGIC_BYTE_3};
+    /*keep track of number of active processes using pid*/
+    int32_t new_pid = assign_PID();
+    if (new_pid == ASSIGN_PID_ERROR){ //If an error was returned (current pid is left untouched)
+        printf("Maximum number of processes running!");
+        slab_free(&io_buf_cache, args);
+        return -1;
+    }
 
-    for (i = 0; i < BYTES_TO_CMPR; i++){ //iterate through the four bytes to see if they're different
-        if(file_bytes[i] != execute_bytes[i]){ //if the execute bytes don't match up
-            // printf("File Read Error! Execute bytes don't match \n");
-            return -1;
+    /*get the new process a kernel stack, a program page table, a PCB and stdin/stdout*/
+    pcb_t* new_pcb = NULL;
+    if (kernel_stack_alloc(new_pid) == 0 && program_paging_init(new_pid, exec_entry) == 0){
+        new_pcb = (pcb_t*)slab_alloc(&pcb_cache);
+    }
+    if (new_pcb != NULL){
+        for (i = 0; i < MAX_OPEN_FILES; i++){
+            new_pcb->fda[i] = NULL; //closed
+        }
+        new_pcb->fda[STDIN_INDEX] = fd_alloc(&stdin, 0, 3);
+        new_pcb->fda[STDOUT_INDEX] = fd_alloc(&stdout, 0, 3);
+        if (new_pcb->fda[STDIN_INDEX] == NULL || new_pcb->fda[STDOUT_INDEX] == NULL){
+            fd_close_all(new_pcb);
+            slab_free(&pcb_cache, new_pcb);
+            new_pcb = NULL;
         }
     }
-
-    /*keep track of number of active processes using pid*/
-    pid = assign_PID();
-    if (pid == ASSIGN_PID_ERROR){ //If an error was returned
-        printf("Maximum number of processes running!");
+    if (new_pcb == NULL){
+        slab_free(&io_buf_cache, args);
+        program_paging_free(new_pid);
+        kernel_stack_free(new_pid);
+        release_PID(new_pid);
+        printf("Out of memory for a new process!");
         return -1;
     }
+    pid = new_pid;
+    pcbs[pid] = new_pcb;
 
-    //complete pcb tasks (put at top of kernel stack) 
+    //complete pcb tasks
     
-    pcb_obj = (pcb_t*)find_PCB(pid);
+    pcb_obj = new_pcb;
     pcb_obj->pcb_pid = pid; //set pid for struct in memory
 
-    //set parent pid within pcb struct
-    if(pid == 0){ //if it's already the first process
-        pcb_obj->parent_pid = -1;
-        parent_pid = -1;
-    }
-    else{
-        pcb_obj->parent_pid = parent_pid;
+    //set parent pid within pcb struct (-1 for a terminal's base shell)
+    pcb_obj->parent_pid = parent_pid;
+
+    //the process runs on the terminal that is being scheduled & becomes its top
+    pcb_obj->terminal_id = sched_terminal;
+    pcb_obj->sched_esp = 0;
+    pcb_obj->vidmap = 0;
+    if(sched_terminal != SCHED_IDLE){
+        terminals[sched_terminal].pid = pid;
     }
 
     pcb_obj->active = 1; //set the pab struct to active
 
     strncpy((int8_t*)pcb_obj->args, (int8_t*)(args), BYTES_32B);
+    slab_free(&io_buf_cache, args);
 
-    /*Set up paging*/
+    /*Set up paging: image pages are loaded by the page fault handler on first touch
+      (shared & copy-on-write when the exec cache holds the image)*/
     execute_paging_init(pid+1);    
+    switch_vidmem(0); //no video page until it calls vidmap (the parent's may be mapped)
 
-    //Copy memory from the file to the virtual memory address
-    uint32_t read_file_ret = read_data(file_inode, file_offset,(uint8_t*)PROGRAM_IMG_VIRT_ADDR, file_length);
-
-    if (read_file_ret != file_length){ //checks bytes_copied in read_data
-        // printf("Error Copying Program Image From File System!");
-        return -1;
-    }
-
-    //initialize file directory
-    for (i = 0; i < MAX_OPEN_FILES; i++){
-        pcb_obj->fda[i].fop = &null;
-        pcb_obj->fda[i].inode_idx = 0;
-        pcb_obj->fda[i].file_position = 0;
-        pcb_obj->fda[i].flags = 0;
-    }
-
-    /*init stdin and stdout*/
-    pcb_obj->fda[STDIN_INDEX].fop = &stdin;
-    pcb_obj->fda[STDOUT_INDEX].fop = &stdout;
-    pcb_obj->fda[STDIN_INDEX].file_type = 3;
-    pcb_obj->fda[STDOUT_INDEX].file_type = 3;
-
-
-    /*set the fda's to be active*/
-    pcb_obj->fda[STDIN_INDEX].flags = 1;
-    pcb_obj->fda[STDOUT_INDEX].flags = 1;
+    //file directory: stdin and stdout were opened above, the rest start closed (NULL)
 
     //complete tss (you must alter ESP0 in TSS to contain its new kernel-mode stack pointer, ss0 = Kernel_CS)
     
     tss.ss0 = KERNEL_DS; //points to kernel code segment for 
-    tss.esp0 = find_PCB(pid - 1) - 4; //points to process’s kernel-mode stack
+    tss.esp0 = kernel_stack_top(pid); //points to process’s kernel-mode stack
     pcb_obj->tss_esp0 = tss.esp0;
 
     /*save esp and ebp to be used by halt */
@@ -263,25 +329,24 @@ int32_t system_execute(const uint8_t* command){
     //calculate esp for user
     uint32_t user_esp = SIZE_128MB + SIZE_4MB - 4;
 
-    //calculate starting address for eip, stored in bytes 24-27
-    uint8_t program_img_starting_addr[FIRST_INST_ADDR_LEN];
-    uint32_t starting_address_len_ret = read_data(file_inode, FISRT_INST_ADDR, program_img_starting_addr, FIRST_INST_ADDR_LEN);
+    //starting address for eip (bytes 24-27) was pulled out when the image was validated
+    uint32_t user_eip = exec_entry->entry_eip;
+    //printf("user_eip = %x\n", user_eip);
 
-    if (starting_address_len_ret != FIRST_INST_ADDR_LEN){
-        // printf("Starting Address Length doesn't match!\n");
-    }
+    execute_stats.launches++;
+    execute_stats.last_cycles = (uint32_t)(rdtsc() - launch_start);
+    execute_stats.total_cycles += execute_stats.last_cycles;
 
-    uint32_t user_eip = *((int*)program_img_starting_addr);
-    //printf("user_eip = %x\n", user_eip);
-    sti(); //enable Interrupts
     //printf("Reach\n");
     uint32_t user_ds = USER_DS;
     uint32_t user_cs = USER_CS;
-    //execute using iret
+    //execute using iret, interrupts come back on with the pushed IF (the scheduler
+    //must not preempt us while still on this stack, it may be the shared launch stack)
     __asm__ volatile(
         "pushl  %0\n"
         "pushl  %1\n"
         "pushfl\n" 
+        "orl    $0x200, (%%esp)\n"
         "pushl  %2\n"
         "pushl  %3\n"
         "iret\n"
@@ -338,7 +403,7 @@ int32_t system_halt(const uint8_t status){
     // printf("HALT: ebp of current process: %d\n", ebp_val);
     /*check if the pid is the base shell (if parent pid is -1)*/
 
-    if(pid == 0 && pcb_obj->parent_pid == -1){ //if so, restart the shell
+    if(pcb_obj->parent_pid == -1){ //if so, restart the shell
 
         /* close current process */
         pcb_obj->active = 0;
@@ -352,18 +417,20 @@ int32_t system_halt(const uint8_t status){
 
         /* fix tss */
         tss.ss0 = KERNEL_DS; // do we need to touch this?
-        tss.esp0 = KERNEL_END - 4;
+        tss.esp0 = kernel_stack_top(pid);
 
         /*redo paging /flushing tlb*/
         execute_paging_init(0);
+        program_paging_free(pid); //the kernel stack is kept, we are still running on it
 
         /* close file descriptors */
-        int i;
-        for (i = 0; i < MAX_OPEN_FILES; i++ ) {
-        pcb_obj->fda[i].flags = 0;
-        }
+        fd_close_all(pcb_obj);
+        slab_free(&pcb_cache, pcb_obj); //execute hands the new shell a fresh one
+        pcbs[pid] = NULL;
         
         //pid = -1;
+        release_PID(pid); //the pid is on top of the free stack again, so the new shell gets it (& this stack)
+        pid = -1; //no parent: execute makes it the terminal's base shell again
         
         system_execute((uint8_t*)"shell");
     }
@@ -382,27 +449,31 @@ int32_t system_halt(const uint8_t status){
 
     /* fix tss */
     tss.ss0 = KERNEL_DS; // do we need to touch this?
-    tss.esp0 = KERNEL_END - (KERNEL_STACK_WIDTH * pcb_obj->parent_pid) - 4;
+    tss.esp0 = kernel_stack_top(pcb_obj->parent_pid);
 
     /* restore paging for parent pid and flushes TLB */
     execute_paging_init(pcb_obj->parent_pid + 1);
+    program_paging_free(pid);
 
     /* Close file descriptors */
-    for (i = 0; i < MAX_OPEN_FILES; i++) {
-        pcb_obj->fda[i].flags = 0;
-        pcb_obj->fda[i].inode_idx = 0;
-        pcb_obj->fda[i].file_position = 0;
-        pcb_obj->fda[i].fop = &null;
-    }
+    fd_close_all(pcb_obj);
     
     /*new current and parent pids*/
+    /*the stack stays readable until we leave it below; interrupts stay off so nothing can reuse it
+      (the iret back to the parent's program turns them back on)*/
+    int32_t halted_pid = pid;
+    kernel_stack_free(pid);
+    release_PID(pid);
     pid = pcb_obj->parent_pid; //writes parent pid to global variable
+    if(pcb_obj->terminal_id != SCHED_IDLE){
+        terminals[pcb_obj->terminal_id].pid = pid; //the parent is the terminal's top again
+    }
     parent_parent_pid = parent_proccess_ptr->parent_pid;
     parent_pid = parent_parent_pid; //writes parent's parent pid to global variable
+    slab_free(&pcb_cache, pcb_obj);
+    pcbs[halted_pid] = NULL;
     pcb_obj = parent_proccess_ptr;
-    
-    /*re-enable interrupts */
-    sti(); 
+    switch_vidmem(pcb_obj->vidmap ? terminals[pcb_obj->terminal_id].video_mem_addr : 0); //the parent's own video page, if any
 
     /* restore parent data (setup return value)*/
     // printf("Halt Assembly Reached\n");
@@ -435,27 +506,62 @@ int32_t system_halt(const uint8_t status){
 *   INPUTS: Opens a file based on the file name and file type associated with it
 *   OUTPUT: Available file descriptor index of file if successful; -1 if fail
 *   NOTES:
-*       - file types: 0 -> rtc; 1 -> directory; 2 -> regular file
+*       - file types: 0 -> rtc; 1 -> directory; 2 -> regular file;
+*         4 -> "stats", 5 -> "irqstats", 6 -> "profile" (kernel files, not in the filesystem image)
 */
 int32_t system_open(const uint8_t* filename){
     dentry_t dentry_obj;
+    file_operations_table_t* kstats_fop = NULL;
+    uint32_t kstats_type = 0;
+    int fd;
+
+    /* kernel statistics & the profiler */
+    if(strncmp((const int8_t*)filename, STATS_FILE_NAME, sizeof(STATS_FILE_NAME)) == 0){
+        kstats_fop = &stats;
+        kstats_type = STATS_FILE_TYPE;
+    }
+    else if(strncmp((const int8_t*)filename, IRQSTATS_FILE_NAME, sizeof(IRQSTATS_FILE_NAME)) == 0){
+        kstats_fop = &irqstats;
+        kstats_type = IRQSTATS_FILE_TYPE;
+    }
+    else if(strncmp((const int8_t*)filename, PROFILE_FILE_NAME, sizeof(PROFILE_FILE_NAME)) == 0){
+        kstats_fop = &profile;
+        kstats_type = PROFILE_FILE_TYPE;
+    }
+    if(kstats_fop != NULL){
+        for (fd = FILE_DESC_START_IDX; fd < MAX_FILE_DESC_IDX; fd++){
+            if(pcb_obj->fda[fd] == NULL){                          // check if file descriptor is available
+                pcb_obj->fda[fd] = fd_alloc(kstats_fop, 0, kstats_type);
+                if(pcb_obj->fda[fd] == NULL){return -1;}                    // out of memory
+                if(kstats_type != PROFILE_FILE_TYPE && kstats_snapshot_alloc(pcb_obj->fda[fd]) != 0){
+                    slab_free(&fd_cache, pcb_obj->fda[fd]);                 // no frames for the text
+                    pcb_obj->fda[fd] = NULL;
+                    return -1;
+                }
+                return fd;
+            }
+        }
+        return -1;
+    }
+
     int read_dentry_ret = read_dentry_by_name(filename, &dentry_obj);
     if(read_dentry_ret != 0){
         //printf("system_open: Cannot open file: %s \n", filename);
         return -1;
     }
 
-    int fd;
 
     /* rtc */
     if (dentry_obj.file_type == 0){ // check if rtc
         for (fd = FILE_DESC_START_IDX; fd < MAX_FILE_DESC_IDX; fd++){ 
-            if(!(pcb_obj->fda[fd].flags)){                          // check if file descriptor is available
-                pcb_obj->fda[fd].inode_idx = dentry_obj.inode_num;
-                pcb_obj->fda[fd].file_position = 0;
-                pcb_obj->fda[fd].flags = 1;                                         // 1 = file in use 
-                pcb_obj->fda[fd].fop = &rtc;
-                pcb_obj->fda[fd].file_type = 0;
+            if(pcb_obj->fda[fd] == NULL){                          // check if file descriptor is available
+                pcb_obj->fda[fd] = fd_alloc(&rtc, dentry_obj.inode_num, 0);
+                if(pcb_obj->fda[fd] == NULL){return -1;}                    // out of memory
+                if(rtc_timer_alloc(pcb_obj->fda[fd]) != 0){                 // every virtual timer taken
+                    slab_free(&fd_cache, pcb_obj->fda[fd]);
+                    pcb_obj->fda[fd] = NULL;
+                    return -1;
+                }
                 //printf("System Open: fd = %d\n", fd);
                 return fd;
             }
@@ -464,12 +570,9 @@ int32_t system_open(const uint8_t* filename){
     /* directory */
     if (dentry_obj.file_type == 1){ // check if directory
         for (fd = FILE_DESC_START_IDX; fd < MAX_FILE_DESC_IDX; fd++){
-            if(!(pcb_obj->fda[fd].flags)){
-                pcb_obj->fda[fd].inode_idx = dentry_obj.inode_num;
-                pcb_obj->fda[fd].file_position = 0;
-                pcb_obj->fda[fd].flags = 1;                                         // 1 = file in use
-                pcb_obj->fda[fd].fop = &directories;
-                pcb_obj->fda[fd].file_type = 1;
+            if(pcb_obj->fda[fd] == NULL){                          // check if file descriptor is available
+                pcb_obj->fda[fd] = fd_alloc(&directories, dentry_obj.inode_num, 1);
+                if(pcb_obj->fda[fd] == NULL){return -1;}                    // out of memory
                 //printf("System Open: fd = %d\n", fd);
                 return fd;
             }
@@ -478,12 +581,9 @@ int32_t system_open(const uint8_t* filename){
     /* file */
     if (dentry_obj.file_type == 2){ // check if file
         for (fd = FILE_DESC_START_IDX; fd < MAX_FILE_DESC_IDX; fd++){
-            if(!(pcb_obj->fda[fd].flags)){
-                pcb_obj->fda[fd].inode_idx = dentry_obj.inode_num;
-                pcb_obj->fda[fd].file_position = 0;
-                pcb_obj->fda[fd].flags = 1;                                         // 1 = file in use
-                pcb_obj->fda[fd].fop = &files;
-                pcb_obj->fda[fd].file_type = 2;
+            if(pcb_obj->fda[fd] == NULL){                          // check if file descriptor is available
+                pcb_obj->fda[fd] = fd_alloc(&files, dentry_obj.inode_num, 2);
+                if(pcb_obj->fda[fd] == NULL){return -1;}                    // out of memory
                 //printf("System Open: fd = %d\n", fd);
                 return fd;
             }
@@ -503,13 +603,12 @@ int32_t system_close(int32_t fd){
     if (fd < FILE_DESC_START_IDX || fd > (MAX_FILE_DESC_IDX - 1)){
         // printf("system_close: Input file descriptor index out of range \n");
         return -1;}            // check if within range (indices 0 and 1 are reserved for stdin & stdout; cannot close stdin/out)
-    if(pcb_obj->fda[fd].flags == 0){return -1;}                                    // check if operations table @ file descriptor is NULL
+    if(pcb_obj->fda[fd] == NULL){return -1;}                                    // check if file descriptor is open
 
-    pcb_obj->fda[fd].inode_idx = 0;
-    pcb_obj->fda[fd].flags = 0;     // close file/file not in use
-    pcb_obj->fda[fd].file_position = 0;     // start at beginnig
-    pcb_obj->fda[fd].fop = &null;
-    pcb_obj->fda[fd].fop->close(fd);
+    rtc_timer_free(pcb_obj->fda[fd]);
+    kstats_snapshot_free(pcb_obj->fda[fd]);
+    slab_free(&fd_cache, pcb_obj->fda[fd]);
+    pcb_obj->fda[fd] = NULL;     // close file/file not in use
     return 0;
 }
 
@@ -530,11 +629,11 @@ int32_t system_read(int32_t fd, void* buf, int32_t nbytes){
     if (fd < STDIN_INDEX || fd > (MAX_FILE_DESC_IDX - 1)){
         // printf("system_read: Input file descriptor index out of range. fd = %d. nbytes = %d \n", fd, nbytes);
         return -1;}             // check if within range (indices 0 and 1 are reserved for stdin & stdout)
-    if(pcb_obj->fda[fd].fop == NULL){return -1;}                                    // check if operations table @ file descriptor is NULL
-    if(!(pcb_obj->fda[fd].flags)){
+    if(pcb_obj->fda[fd] == NULL){
         // printf("system_read: File not open \n");
-        return -1;}                               // check if file is closed & cannot read (flag = 0)
-    return pcb_obj->fda[fd].fop->read(fd, buf, nbytes);                     // select which operation from file_operations_table
+        return -1;}                               // check if file is closed & cannot read
+    if(pcb_obj->fda[fd]->fop == NULL){return -1;}                                    // check if operations table @ file descriptor is NULL
+    return pcb_obj->fda[fd]->fop->read(fd, buf, nbytes);                     // select which operation from file_operations_table
 }
 /*
 *   Function Name: system_write (int32_t fd, void* buf, int32_t nbytes)
@@ -552,10 +651,9 @@ int32_t system_write(int32_t fd, void* buf, int32_t nbytes){
     if (fd < STDIN_INDEX || fd > (MAX_FILE_DESC_IDX - 1)){
         // printf("system_write: Input file descriptor index out of range. fd = %d \n", fd);
         return -1;}            // check if within range (indices 0 and 1 are reserved for stdin & stdout; cannot close stdin/out)
-    if(pcb_obj->fda[fd].fop == NULL){return -1;}                                    // check if operations table @ file descriptor is NULL
-    // wasn't getting past this conditional -------> //if(!(pcb_obj->fda[fd].flags)){return -1;}                               // check if file is closed & cannot read (flag = 0)
+    if(pcb_obj->fda[fd] == NULL || pcb_obj->fda[fd]->fop == NULL){return -1;}       // check if file is closed or operations table @ file descriptor is NULL
     //printf("reached \n");
-    int ret_val = pcb_obj->fda[fd].fop->write(fd, buf, nbytes);                     // select which operation from file_operations_table
+    int ret_val = pcb_obj->fda[fd]->fop->write(fd, buf, nbytes);                     // select which operation from file_operations_table
     return ret_val;
 }
 
@@ -582,7 +680,7 @@ int32_t system_getargs(uint8_t* buf, int32_t nbytes){
 /* Function Name: system_vidmap(uint8_t** screen_start)
 *   INPUTS: screen_start  - pointer to the start of video memory
 *   OUTPUT: 0 if successful; -1 if fail
-*   NOTES:  - maps the text-mode video memory into user space at a pre-set virtual address
+*   NOTES:  - maps the caller's terminal's text page into user space at a pre-set virtual address
 *           - returns 0 if successful
 *           - returns -1 if fail
 */
@@ -600,13 +698,201 @@ int32_t system_vidmap(uint8_t** screen_start){
     
     *screen_start = (uint8_t*) USER_VMEM_ADDR; //set screen_start to the correct address
 
-    map_vidmem(); //map video memory and flush TLB
+    pcb_obj->vidmap = 1; //the scheduler maps it back in whenever this process runs
+    map_vidmem(terminals[pcb_obj->terminal_id].video_mem_addr); //map the caller's terminal page and flush TLB
     
     return 0;
 }
 
+/* Function Name: system_set_handler(int32_t signum, void* handler_address)
+*   INPUTS: signum - signal number, handler_address - user level handler
+*   OUTPUT: -1 (signals are not supported)
+*   NOTES:  - keeps the call numbers below system_ioctl in the jump table
+*/
+int32_t system_set_handler(int32_t signum, void* handler_address){
+    return -1;
+}
+
+/* Function Name: system_sigreturn(void)
+*   INPUTS: none
+*   OUTPUT: -1 (signals are not supported)
+*/
+int32_t system_sigreturn(void){
+    return -1;
+}
+
+/* Function Name: system_ioctl(int32_t fd, int32_t cmd, void* arg)
+*   INPUTS: fd - open file descriptor, cmd - driver specific command, arg - its argument
+*   OUTPUT: whatever the driver returns; -1 if fail
+*   NOTES:  - device control that doesn't fit read/write, e.g. RTC_IOC_RATE_TICKS
+*           - dispatched through the descriptor's file operations table like read/write
+*/
+int32_t system_ioctl(int32_t fd, int32_t cmd, void* arg){
+    if(fd < 0 || fd >= MAX_FILE_DESC_IDX){return -1;}                             // check if within range
+    if(pcb_obj->fda[fd] == NULL || pcb_obj->fda[fd]->fop == NULL){return -1;}       // check if file is closed or operations table @ file descriptor is NULL
+    return pcb_obj->fda[fd]->fop->ioctl(fd, cmd, arg);
+}
+
+/* Function Name: system_readv(int32_t fd, const iovec_t* iov, int32_t iovcnt)
+*   INPUTS: fd - open file descriptor, iov - buffers to fill in order, iovcnt - how many
+*   OUTPUT: total bytes read; -1 if fail
+*   NOTES:  - one trap for up to IOV_MAX reads through the descriptor's read operation
+*           - stops early at a short read (end of file, end of a line on the terminal)
+*/
+int32_t system_readv(int32_t fd, const iovec_t* iov, int32_t iovcnt){
+    int32_t i;
+    if(iovcnt <= 0 || iovcnt > IOV_MAX){return -1;}
+    if(bad_userspace_addr(iov, iovcnt * sizeof(iovec_t))){return -1;}
+    for(i = 0; i < iovcnt; i++){
+        if(bad_userspace_addr(iov[i].base, iov[i].len)){return -1;}
+    }
+    return io_vector(fd, iov, iovcnt, 0);
+}
+
+/* Function Name: system_writev(int32_t fd, const iovec_t* iov, int32_t iovcnt)
+*   INPUTS: fd - open file descriptor, iov - buffers to write in order, iovcnt - how many
+*   OUTPUT: total bytes written; -1 if fail
+*   NOTES:  - one trap for up to IOV_MAX writes through the descriptor's write operation,
+*             e.g. grep's "file:line\n" in one call instead of four
+*/
+int32_t system_writev(int32_t fd, const iovec_t* iov, int32_t iovcnt){
+    int32_t i;
+    if(iovcnt <= 0 || iovcnt > IOV_MAX){return -1;}
+    if(bad_userspace_addr(iov, iovcnt * sizeof(iovec_t))){return -1;}
+    for(i = 0; i < iovcnt; i++){
+        if(bad_userspace_addr(iov[i].base, iov[i].len)){return -1;}
+    }
+    return io_vector(fd, iov, iovcnt, 1);
+}
+
+/* Function Name: system_io_enter(io_ring_t* ring)
+*   INPUTS: ring - the program's submission ring
+*   OUTPUT: number of entries run; -1 if fail
+*   NOTES:  - runs every queued read/write in one trap; each entry gets its own result,
+*             a bad buffer or descriptor only fails that entry
+*/
+int32_t system_io_enter(io_ring_t* ring){
+    if(bad_userspace_addr(ring, sizeof(io_ring_t))){return -1;}
+    return io_ring_run(ring, 1);
+}
+
 /*HELPER FUNCTIONS*/ 
 
+/*Function name: fd_io(int32_t fd, void* buf, int32_t nbytes, int32_t write)
+*   INPUTS: fd -- descriptor of the caller, buf/nbytes -- the transfer, write -- 1 to write, 0 to read
+*   OUTPUT: whatever the descriptor's read/write returns; -1 on a bad or closed descriptor
+*/
+static int32_t fd_io(int32_t fd, void* buf, int32_t nbytes, int32_t write){
+    file_descriptor_t* desc;
+    if(buf == NULL || fd < STDIN_INDEX || fd > (MAX_FILE_DESC_IDX - 1)){return -1;}
+    desc = pcb_obj->fda[fd];
+    if(desc == NULL || desc->fop == NULL){return -1;}
+    return write ? desc->fop->write(fd, buf, nbytes) : desc->fop->read(fd, buf, nbytes);
+}
+
+/*Function name: io_vector(int32_t fd, const iovec_t* iov, int32_t iovcnt, int32_t write)
+*   INPUTS: fd -- descriptor, iov/iovcnt -- checked buffers, write -- 1 for writev, 0 for readv
+*   OUTPUT: total bytes moved; -1 if the first piece fails
+*   NOTES:  a later failure or short transfer ends the call with what was moved so far
+*/
+int32_t io_vector(int32_t fd, const iovec_t* iov, int32_t iovcnt, int32_t write){
+    int32_t i, ret;
+    int32_t total = 0;
+    for(i = 0; i < iovcnt; i++){
+        if(iov[i].len == 0){continue;}
+        ret = fd_io(fd, iov[i].base, iov[i].len, write);
+        if(ret < 0){
+            return (total == 0) ? -1 : total;
+        }
+        total += ret;
+        if(ret < iov[i].len){break;}
+    }
+    return total;
+}
+
+/*Function name: io_ring_run(io_ring_t* ring, int32_t user)
+*   INPUTS: ring -- a checked submission ring, user -- 1 if entry buffers must be in the program page
+*   OUTPUT: number of entries run; -1 if more than IO_RING_SIZE are queued
+*   NOTES:  entries run in queue order (so writes to the terminal come out in order)
+*/
+int32_t io_ring_run(io_ring_t* ring, int32_t user){
+    uint32_t head = ring->head;
+    uint32_t tail = ring->tail;
+    uint32_t count = tail - head;
+    io_sqe_t* sqe;
+    if(count > IO_RING_SIZE){return -1;}
+    for(; head != tail; head++){
+        sqe = &ring->sqe[head & IO_RING_MASK];
+        switch(sqe->op){
+        case IO_OP_NOP:
+            sqe->result = 0;
+            break;
+        case IO_OP_READ:
+        case IO_OP_WRITE:
+            if(user && bad_userspace_addr(sqe->buf, sqe->len)){
+                sqe->result = -1;
+                break;
+            }
+            sqe->result = fd_io(sqe->fd, sqe->buf, sqe->len, sqe->op == IO_OP_WRITE);
+            break;
+        default:
+            sqe->result = -1;
+            break;
+        }
+    }
+    ring->head = head;
+    return count;
+}
+
+
+/*Function name: fd_alloc(file_operations_table_t* fop, uint32_t inode, uint32_t type)
+*   INPUTS: fop -- operations for the file, inode -- inode index, type -- file type
+*   OUTPUT: an open file descriptor from fd_cache; NULL if out of memory
+*/
+static file_descriptor_t* fd_alloc(file_operations_table_t* fop, uint32_t inode, uint32_t type){
+    file_descriptor_t* desc = (file_descriptor_t*)slab_alloc(&fd_cache);
+    if(desc == NULL){
+        return NULL;
+    }
+    desc->fop = fop;
+    desc->inode_idx = inode;
+    desc->file_position = 0;
+    desc->flags = 1;                // 1 = file in use
+    desc->file_type = type;
+    desc->rtc_timer = NULL;
+    desc->stats_snapshot = NULL;
+    return desc;
+}
+
+/*Function name: fd_close_all(pcb_t* pcb)
+*   INPUTS: pcb -- process whose files are closed
+*   OUTPUT: none
+*   NOTES:  - gives every open file descriptor back to fd_cache
+*/
+static void fd_close_all(pcb_t* pcb){
+    int i;
+    for(i = 0; i < MAX_OPEN_FILES; i++){
+        if(pcb->fda[i] != NULL){
+            rtc_timer_free(pcb->fda[i]);
+            kstats_snapshot_free(pcb->fda[i]);
+        }
+        slab_free(&fd_cache, pcb->fda[i]);
+        pcb->fda[i] = NULL;
+    }
+}
+
+/*Function name: get_execute_stats(execute_stats_t* stats)
+*   INPUTS: stats -- filled with the launch counters
+*   OUTPUT: none
+*   NOTES:  - cycles are counted from entering system_execute to the iret into the program
+*/
+void get_execute_stats(execute_stats_t* stats){
+    if(stats == NULL){
+        return;
+    }
+    *stats = execute_stats;
+}
+
 /*Returns address for top of kernel stack for the given pid, 
 which also corresponds to the given pid's kernel stack*/
 /*Function name: find_PCB(int32_t pid)
@@ -615,24 +901,105 @@ which also corresponds to the given pid's kernel stack*/
 *   NOTES:  - returns address of PCB struct for given pid
 */
 int32_t find_PCB(int32_t pid){
-    return END_OF_KERNEL_PAGE - (KERNEL_STACK_SIZE *(pid + 1)); 
+    return (int32_t)pcbs[pid]; 
+}
+
+/*Function name: kernel_stack_top(int32_t pid)
+*   INPUTS: pid
+*   OUTPUT: esp0 for the pid's kernel stack
+*/
+uint32_t kernel_stack_top(int32_t pid){
+    return kernel_stacks[pid] + KERNEL_STACK_SIZE - 4;
+}
+
+/*Gives a pid a kernel stack from the frame pool (a restarted base shell keeps its old one)*/
+/*Function name: kernel_stack_alloc(int32_t pid)
+*   INPUTS: pid
+*   OUTPUT: 0 if the pid has a kernel stack; -1 if the frame pool is empty
+*/
+int32_t kernel_stack_alloc(int32_t pid){
+    if (kernel_stacks[pid] == 0) {
+        kernel_stacks[pid] = frame_alloc_contig(KERNEL_STACK_FRAMES);
+    }
+    return (kernel_stacks[pid] == FRAME_NONE) ? -1 : 0;
+}
+
+/*Function name: kernel_stack_free(int32_t pid)
+*   INPUTS: pid
+*   OUTPUT: none
+*   NOTES:  - the frames keep their contents until someone allocates them again
+*/
+void kernel_stack_free(int32_t pid){
+    if (kernel_stacks[pid] != 0) {
+        frame_free_contig(kernel_stacks[pid], KERNEL_STACK_FRAMES);
+        kernel_stacks[pid] = 0;
+    }
 }
 
 
-/*Checks the PCB structs to see if they are active for both PIDs*/
+/*Function name: pid_allocator_init()
+*   INPUTS: none
+*   OUTPUT: none
+*   NOTES:  - marks every pid free; pid 0 ends up on top of the stack so the
+*             first shell gets it, and pids are handed out lowest first
+*/
+void pid_allocator_init(){
+    int32_t i;
+    for (i = 0; i < MAX_PROCESSES; i++) {
+        pid_free_stack[i] = MAX_PROCESSES - 1 - i;
+        pid_in_use[i] = 0;
+    }
+    pid_free_top = MAX_PROCESSES;
+    memset(&pid_stats, 0, sizeof(pid_stats));
+}
+
+/*Pops a free pid off the free stack in O(1)*/
 /*Function name: assign_pid()
 *   INPUTS: none
 *   OUTPUT: pid if successful; -1 if fail
 *   NOTES:  - returns pid if successful
-*           - returns ASSIGN_PID_ERROR if fail
+*           - returns ASSIGN_PID_ERROR if fail (counted as an exhaustion)
 */
 int32_t assign_PID(){
-    int i; 
-    for (i = 0; i < MAX_PROCESSES; i++) {   
-        if (((pcb_t *)find_PCB(i))->active == 0) { 
-            return i;
-        }
+    int32_t new_pid;
+    if (pid_free_top == 0) {
+        pid_stats.exhaustions++;
+        return ASSIGN_PID_ERROR;
+    }
+    new_pid = pid_free_stack[--pid_free_top];
+    pid_in_use[new_pid] = 1;
+    pid_stats.allocations++;
+    pid_stats.in_use++;
+    if (pid_stats.in_use > pid_stats.high_water) {
+        pid_stats.high_water = pid_stats.in_use;
+    }
+    return new_pid;
+}
+
+/*Pushes a pid back on the free stack in O(1)*/
+/*Function name: release_PID(int32_t pid)
+*   INPUTS: pid -- pid of the process being halted
+*   OUTPUT: 0 if successful; -1 if the pid was not allocated
+*   NOTES:  - the most recently released pid is the next one handed out
+*/
+int32_t release_PID(int32_t pid){
+    if (pid < 0 || pid >= MAX_PROCESSES || !pid_in_use[pid]) {
+        return -1;
+    }
+    pid_in_use[pid] = 0;
+    pid_free_stack[pid_free_top++] = pid;
+    pid_stats.frees++;
+    pid_stats.in_use--;
+    return 0;
+}
+
+/*Function name: get_pid_stats(pid_stats_t* stats)
+*   INPUTS: stats -- filled with the allocator counters
+*   OUTPUT: none
+*/
+void get_pid_stats(pid_stats_t* stats){
+    if(stats == NULL){
+        return;
     }
-    printf("assign_PID: Maximum processes running!\n"); 
-    return ASSIGN_PID_ERROR;    
+    *stats = pid_stats;
 }
@@ -14,6 +14,10 @@
 #include "x86_desc.h"
 #include "paging.h"
 #include "terminal_driver.h"
+#include "exec_cache.h"
+#include "slab.h"
+#include "kstats.h"
+#include "profile.h"
 
 #define MAGIC_EXECUTABLE 0x464c457f //ELF
 #define KERNEL_END 0x800000     //8MB
@@ -30,10 +34,65 @@
 #define STDIN_INDEX                 0
 #define STDOUT_INDEX                1
 
+/* Launch latency counters for system_execute */
+typedef struct execute_stats{
+    uint32_t launches;
+    uint32_t last_cycles;       // cycles from entering system_execute to the iret
+    uint64_t total_cycles;
+} execute_stats_t;
+
+/* PID allocator counters */
+typedef struct pid_stats{
+    uint32_t allocations;
+    uint32_t frees;
+    uint32_t exhaustions;       // assign_PID calls with every pid in use
+    uint32_t in_use;
+    uint32_t high_water;        // most pids ever in use at once
+} pid_stats_t;
+
+/* readv/writev: one piece of a vectored transfer */
+#define IOV_MAX             16          //pieces per readv/writev call
+typedef struct iovec{
+    void* base;
+    int32_t len;
+} iovec_t;
+
+/* Submission ring for system_io_enter: the program queues entries at tail, the kernel
+   runs everything from head to tail, leaves each result in its entry & moves head up */
+#define IO_RING_SIZE        32          //a power of 2
+#define IO_RING_MASK        (IO_RING_SIZE - 1)
+#define IO_OP_NOP           0
+#define IO_OP_READ          1
+#define IO_OP_WRITE         2
+typedef struct io_sqe{
+    int32_t op;
+    int32_t fd;
+    void* buf;
+    int32_t len;
+    int32_t result;             //filled in by the kernel: bytes moved or -1
+} io_sqe_t;
+typedef struct io_ring{
+    uint32_t head;              //written by the kernel
+    uint32_t tail;              //written by the program
+    io_sqe_t sqe[IO_RING_SIZE];
+} io_ring_t;
+
+/* Current process (restored by the scheduler on every switch) */
+extern int32_t pid;
+extern int32_t parent_pid;
+
 /*systemcall linkage */
 extern void syscall_handler(); //systemcall_header.S
+extern void sysenter_handler(); //systemcall_header.S, the SYSENTER entry
+
+#define IA32_SYSENTER_CS    0x174
+#define IA32_SYSENTER_ESP   0x175
+#define IA32_SYSENTER_EIP   0x176
+#define CPUID_SEP           (1 << 11)   //CPUID 1 edx: SYSENTER/SYSEXIT present
+#define SYSENTER_STACK_WORDS 64
 
 void file_operations_initialize(void); //initialize file operations table
+int32_t sysenter_init(void); //program the SYSENTER MSRs
 
 /* Global Pointers to Start of Process Objects */
 file_operations_table_t null;          // for when there is no file operator connection
@@ -42,6 +101,9 @@ file_operations_table_t stdout;        // terminal
 file_operations_table_t rtc;          // rtc
 file_operations_table_t files;         // files
 file_operations_table_t directories;  // directories
+file_operations_table_t stats;        // system call statistics (kstats.c)
+file_operations_table_t irqstats;     // interrupt statistics (kstats.c)
+file_operations_table_t profile;      // sampling profiler (profile.c)
 
 /*System Call Declarations*/
 int32_t system_execute(const uint8_t* command); 
@@ -52,10 +114,27 @@ int32_t system_open(const uint8_t* filename);
 int32_t system_close(int32_t fd);
 int32_t system_getargs(uint8_t* buf, int32_t nbytes);
 int32_t system_vidmap(uint8_t** screen_start);
+int32_t system_set_handler(int32_t signum, void* handler_address);
+int32_t system_sigreturn(void);
+int32_t system_ioctl(int32_t fd, int32_t cmd, void* arg);
+int32_t system_readv(int32_t fd, const iovec_t* iov, int32_t iovcnt);
+int32_t system_writev(int32_t fd, const iovec_t* iov, int32_t iovcnt);
+int32_t system_io_enter(io_ring_t* ring);
+
+/* the work behind readv/writev & io_enter, once the user pointers are checked */
+int32_t io_vector(int32_t fd, const iovec_t* iov, int32_t iovcnt, int32_t write);
+int32_t io_ring_run(io_ring_t* ring, int32_t user);
 
 /*helper function declarations*/
 int32_t find_PCB(int32_t pid);
+int32_t kernel_stack_alloc(int32_t pid);
+void kernel_stack_free(int32_t pid);
+uint32_t kernel_stack_top(int32_t pid);
+void pid_allocator_init();
 int32_t assign_PID();
+int32_t release_PID(int32_t pid);
+void get_pid_stats(pid_stats_t* stats);
+void get_execute_stats(execute_stats_t* stats);
 
 
 
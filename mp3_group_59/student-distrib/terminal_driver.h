@@ -9,6 +9,7 @@
 #include "lib.h"
 #include "syscall.h"
 #include "paging.h"
+#include "scrollback.h"
 
 #define VIDEO       0xB8000
 #define NUM_COLS    80
@@ -23,9 +24,12 @@ typedef struct terminal_struct{
     
     uint32_t video_mem_addr;                        // stores starting address of the terminal's video memory page
     uint32_t active; //1 if active, 0 if not
-    uint8_t keyboard_buffer[128];
+    kb_ring_t input;                                // typed lines waiting for terminal_read (type-ahead)
     uint32_t screen_X;
     uint32_t screen_Y;
+    int32_t pid;                // process on top of this terminal's execute chain, -1 if none yet
+    wait_queue_t read_queue;    // terminal_read waiting for a finished line
+    scrollback_t scrollback;    // rows scrolled off the top (Shift+PgUp/PgDn)
    
 }terminal_t; //process control block
 
@@ -9,6 +9,8 @@
 #include "rtc.h"
 #include "terminal_driver.h"
 #include "filesystem.h"
+#include "exec_cache.h"
+#include "scheduler.h"
 
 int idt_test(void);
 
@@ -31,5 +33,32 @@ int test_directory_open(void);
 int test_directory_close(void);
 int test_directory_write(void);
 int test_read_directory(void);
+int test_read_data_runs(void);
+int read_data_benchmark(void);
+int test_name_index(void);
+int test_exec_cache(void);
+int test_cow_pages(void);
+int launch_latency_benchmark(void);
+int test_pid_allocator(void);
+int test_frame_allocator(void);
+int frame_benchmark(void);
+int test_slab_allocator(void);
+int slab_benchmark(void);
+int tlb_global_benchmark(void);
+int context_switch_benchmark(void);
+int test_wait_queue(void);
+int test_virtual_rtc(void);
+int rtc_rate_benchmark(void);
+int test_kb_ring(void);
+int terminal_write_benchmark(void);
+int scroll_benchmark(void);
+int scrollback_benchmark(void);
+int test_terminal_switch(void);
+int test_background_output(void);
+int test_sysenter_msrs(void);
+int test_vectored_io(void);
+int test_syscall_stats(void);
+int test_irq_stats(void);
+int test_profiler(void);
 
 #endif /* TESTS_H */
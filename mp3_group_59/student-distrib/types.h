@@ -20,6 +20,9 @@
 #define BYTES_4KB       4096
 
 /* Types defined here just like in <stdint.h> */
+typedef long long int64_t;
+typedef unsigned long long uint64_t;
+
 typedef int int32_t;
 typedef unsigned int uint32_t;
 
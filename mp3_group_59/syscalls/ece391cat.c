@@ -3,30 +3,70 @@
 #include "ece391support.h"
 #include "ece391syscall.h"
 
+#define BUFSIZE 1024
+#define NBUFS 8
+
+static void queue (io_ring_t* ring, int32_t op, int32_t fd, void* buf, int32_t len)
+{
+    io_sqe_t* sqe = &ring->sqe[ring->tail % IO_RING_SIZE];
+
+    sqe->op = op;
+    sqe->fd = fd;
+    sqe->buf = buf;
+    sqe->len = len;
+    ring->tail++;
+}
+
 int main ()
 {
-    int32_t fd, cnt;
-    uint8_t buf[1024];
+    int32_t fd, cnt, i, done;
+    uint32_t base;
+    uint8_t buf[NBUFS][BUFSIZE];
+    io_ring_t ring;
 
-    if (0 != ece391_getargs (buf, 1024)) {
+    if (0 != ece391_getargs (buf[0], BUFSIZE)) {
         ece391_fdputs (1, (uint8_t*)"could not read arguments\n");
 	return 3;
     }
 
-    if (-1 == (fd = ece391_open (buf))) {
+    if (-1 == (fd = ece391_open (buf[0]))) {
         ece391_fdputs (1, (uint8_t*)"file not found\n");
 	return 2;
     }
 
-    while (0 != (cnt = ece391_read (fd, buf, 1024))) {
-        if (-1 == cnt) {
+    /* NBUFS reads in one call, then the writes for whatever they got in another */
+    ring.head = ring.tail = 0;
+    done = 0;
+    while (!done) {
+	for (i = 0; i < NBUFS; i++)
+	    queue (&ring, IO_OP_READ, fd, buf[i], BUFSIZE);
+	if (-1 == ece391_io_enter (&ring)) {
 	    ece391_fdputs (1, (uint8_t*)"file read failed\n");
 	    return 3;
 	}
-	if (-1 == ece391_write (1, buf, cnt))
-	    return 3;
+
+	base = ring.tail;
+	for (i = 0; i < NBUFS; i++) {
+	    cnt = ring.sqe[(base - NBUFS + i) % IO_RING_SIZE].result;
+	    if (-1 == cnt) {
+		ece391_fdputs (1, (uint8_t*)"file read failed\n");
+		return 3;
+	    }
+	    if (0 == cnt) {
+		done = 1;
+		break;
+	    }
+	    queue (&ring, IO_OP_WRITE, 1, buf[i], cnt);
+	}
+
+	if (ring.tail != base) {
+	    if (-1 == ece391_io_enter (&ring))
+		return 3;
+	    for (; base != ring.tail; base++)
+		if (-1 == ring.sqe[base % IO_RING_SIZE].result)
+		    return 3;
+	}
     }
 
     return 0;
 }
-
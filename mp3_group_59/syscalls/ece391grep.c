@@ -11,6 +11,7 @@ do_one_file (const char* s, const char* fname)
 {
     int32_t fd, cnt, last, line_start, line_end, check, s_len;
     uint8_t data[BUFSIZE+1];
+    iovec_t match[4];
 
     s_len = ece391_strlen ((uint8_t*)s);
     if (-1 == (fd = ece391_open ((uint8_t*)fname))) {
@@ -42,10 +43,16 @@ do_one_file (const char* s, const char* fname)
 	    for (check = line_start; check < line_end; check++) {
 		if (s[0] == data[check] && 
 		    0 == ece391_strncmp ((uint8_t*)(data + check), (uint8_t*)s, s_len)) {
-		    ece391_fdputs (1, (uint8_t*)fname);
-		    ece391_fdputs (1, (uint8_t*)":");
-		    ece391_fdputs (1, data + line_start);
-		    ece391_fdputs (1, (uint8_t*)"\n");
+		    /* "file:line\n" in one call */
+		    match[0].base = (void*)fname;
+		    match[0].len = ece391_strlen ((uint8_t*)fname);
+		    match[1].base = ":";
+		    match[1].len = 1;
+		    match[2].base = data + line_start;
+		    match[2].len = ece391_strlen (data + line_start);
+		    match[3].base = "\n";
+		    match[3].len = 1;
+		    (void)ece391_writev (1, match, 4);
 		    break;
 		}
 	    }
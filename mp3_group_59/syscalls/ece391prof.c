@@ -0,0 +1,36 @@
+#include <stdint.h>
+
+#include "ece391support.h"
+#include "ece391syscall.h"
+
+#define BUFSIZE 1024
+
+/* prof start|stop|reset: hands the command to the kernel profiler
+   prof dump: stops it & prints the samples for profile.sh */
+int main ()
+{
+    int32_t fd, cnt;
+    uint8_t buf[BUFSIZE];
+
+    if (0 != ece391_getargs (buf, BUFSIZE)) {
+        ece391_fdputs (1, (uint8_t*)"usage: prof start|stop|reset|dump\n");
+        return 3;
+    }
+    if (-1 == (fd = ece391_open ((uint8_t*)"profile"))) {
+        ece391_fdputs (1, (uint8_t*)"profile file not found\n");
+        return 2;
+    }
+
+    if (0 == ece391_strcmp (buf, (uint8_t*)"dump")) {
+        ece391_write (fd, "stop", 4);
+        while (0 < (cnt = ece391_read (fd, buf, BUFSIZE)))
+            ece391_write (1, buf, cnt);
+    } else if (-1 == ece391_write (fd, buf, ece391_strlen (buf))) {
+        ece391_fdputs (1, (uint8_t*)"usage: prof start|stop|reset|dump\n");
+        ece391_close (fd);
+        return 3;
+    }
+
+    ece391_close (fd);
+    return 0;
+}
@@ -0,0 +1,57 @@
+#include <stdint.h>
+
+#include "ece391support.h"
+#include "ece391syscall.h"
+
+#define BUFSIZE 33
+#define DEFAULT_DEPTH 64
+#define SCRATCH_SIZE 16384
+
+/* touched on every level so each process needs its own bss frames */
+static uint8_t scratch[SCRATCH_SIZE];
+
+/*
+ * spawn [depth] -- stress the process table by executing itself depth
+ * levels deep (or until execute fails) and report how many nested
+ * processes were started. Nested copies get a '+' in front of their
+ * depth so only the outermost one prints.
+ */
+int main ()
+{
+    uint8_t buf[BUFSIZE];
+    uint8_t cmd[BUFSIZE];
+    uint32_t depth = DEFAULT_DEPTH;
+    uint32_t nested = 0;
+    uint32_t i = 0;
+    int32_t ret;
+
+    if (0 == ece391_getargs (buf, BUFSIZE) && '\0' != buf[0]) {
+        if ('+' == buf[0]) {
+            nested = 1;
+            i = 1;
+        }
+        for (depth = 0; buf[i] >= '0' && buf[i] <= '9'; i++)
+            depth = depth * 10 + (buf[i] - '0');
+    }
+
+    for (i = 0; i < SCRATCH_SIZE; i += 4096)
+        scratch[i] = (uint8_t)depth;
+
+    ret = -1;
+    if (depth > 0) {
+        ece391_strcpy (cmd, (uint8_t*)"spawn +");
+        ece391_itoa (depth - 1, cmd + 7, 10);
+        ret = ece391_execute (cmd);
+    }
+    ret = (-1 == ret) ? 0 : ret + 1;   /* -1: bottom reached or process table full */
+    if (ret > 254)
+        ret = 254;                     /* halt turns 255 into 256 (exception) */
+
+    if (!nested) {
+        ece391_fdputs (1, (uint8_t*)"spawn: ");
+        ece391_itoa (ret, buf, 10);
+        ece391_fdputs (1, buf);
+        ece391_fdputs (1, (uint8_t*)" nested processes started\n");
+    }
+    return ret;
+}
@@ -0,0 +1,181 @@
+#include <stdint.h>
+
+#include "ece391support.h"
+#include "ece391syscall.h"
+
+#define BUFSIZE 8192
+#define NUMSIZE 16
+#define MAXFIELDS 40
+#define NAMEWIDTH 12
+#define NUMWIDTH 11
+#define BARWIDTH 40
+
+/* prints s right aligned in width columns (left aligned if left is set) */
+static void column (const uint8_t* s, uint32_t width, int32_t left)
+{
+    uint32_t len = ece391_strlen (s);
+
+    if (left)
+        ece391_fdputs (1, s);
+    for (; len < width; len++)
+        ece391_fdputs (1, (uint8_t*)" ");
+    if (!left)
+        ece391_fdputs (1, s);
+}
+
+static void number (uint32_t value, uint32_t width)
+{
+    uint8_t buf[NUMSIZE];
+
+    ece391_itoa (value, buf, 10);
+    column (buf, width, 0);
+}
+
+static uint32_t atou (const uint8_t* s)
+{
+    uint32_t value = 0;
+
+    while (*s >= '0' && *s <= '9')
+        value = value * 10 + (*s++ - '0');
+    return value;
+}
+
+/* one line of the stats file: name calls timed avg max [first count...] */
+static void show_call (uint8_t** field, int32_t nfields)
+{
+    uint32_t first, count, most, i, b;
+    uint8_t buf[NUMSIZE];
+
+    column (field[0], NAMEWIDTH, 1);
+    for (i = 1; i < 5; i++)
+        number (atou (field[i]), NUMWIDTH);
+    ece391_fdputs (1, (uint8_t*)"\n");
+    if (nfields < 7)
+        return;
+
+    first = atou (field[5]);
+    most = 1;
+    for (i = 6; i < nfields; i++)
+        if (atou (field[i]) > most)
+            most = atou (field[i]);
+    for (i = 6, b = first; i < nfields; i++, b++) {
+        count = atou (field[i]);
+        ece391_fdputs (1, (uint8_t*)"    >= 2^");
+        ece391_itoa (b, buf, 10);
+        column (buf, 2, 1);
+        ece391_fdputs (1, (uint8_t*)" |");
+        for (count = (count * BARWIDTH + most - 1) / most; count > 0; count--)
+            ece391_fdputs (1, (uint8_t*)"#");
+        ece391_fdputs (1, (uint8_t*)" ");
+        number (atou (field[i]), 0);
+        ece391_fdputs (1, (uint8_t*)"\n");
+    }
+}
+
+/* one line of the irqstats file:
+   vector name count per_second timed avg min max cost_permille switched */
+static void show_irq (uint8_t** field, int32_t nfields)
+{
+    uint32_t permille, i;
+    uint8_t buf[NUMSIZE];
+
+    if (nfields < 10)
+        return;
+    column (field[0], 4, 0);
+    ece391_fdputs (1, (uint8_t*)" ");
+    column (field[1], NAMEWIDTH, 1);
+    for (i = 2; i < 8; i++)
+        if (i != 4)
+            number (atou (field[i]), NUMWIDTH - 1);
+    permille = atou (field[8]);
+    ece391_itoa (permille / 10, buf, 10);
+    column (buf, 5, 0);
+    ece391_fdputs (1, (uint8_t*)".");
+    ece391_itoa (permille % 10, buf, 10);
+    ece391_fdputs (1, buf);
+    ece391_fdputs (1, (uint8_t*)"%");
+    number (atou (field[9]), NUMWIDTH - 1);
+    ece391_fdputs (1, (uint8_t*)"\n");
+}
+
+/* reads a whole statistics file into buf, NUL terminated */
+static int32_t slurp (const uint8_t* name, uint8_t* buf)
+{
+    int32_t fd, cnt, len;
+
+    if (-1 == (fd = ece391_open (name))) {
+        ece391_fdputs (1, name);
+        ece391_fdputs (1, (uint8_t*)" file not found\n");
+        return -1;
+    }
+    for (len = 0; len < BUFSIZE - 1; len += cnt) {
+        if (-1 == (cnt = ece391_read (fd, buf + len, BUFSIZE - 1 - len))) {
+            ece391_fdputs (1, name);
+            ece391_fdputs (1, (uint8_t*)" file read failed\n");
+            ece391_close (fd);
+            return -1;
+        }
+        if (0 == cnt)
+            break;
+    }
+    buf[len] = '\0';
+    ece391_close (fd);
+    return len;
+}
+
+/* splits each line into its space separated fields & hands them to show */
+static void each_line (uint8_t* buf, void (*show) (uint8_t** field, int32_t nfields))
+{
+    int32_t nfields;
+    uint8_t* field[MAXFIELDS];
+    uint8_t* s;
+
+    for (s = buf; *s != '\0'; s++) {
+        nfields = 0;
+        while (*s != '\0' && *s != '\n') {
+            if (nfields < MAXFIELDS)
+                field[nfields++] = s;
+            while (*s != '\0' && *s != ' ' && *s != '\n')
+                s++;
+            if (*s == ' ')
+                *s++ = '\0';
+        }
+        if (*s == '\n')
+            *s = '\0';
+        else
+            s--;
+        if (nfields >= 5)
+            show (field, nfields);
+    }
+}
+
+int main ()
+{
+    uint8_t buf[BUFSIZE];
+
+    if (-1 == slurp ((uint8_t*)"stats", buf))
+        return 2;
+    column ((uint8_t*)"call", NAMEWIDTH, 1);
+    column ((uint8_t*)"calls", NUMWIDTH, 0);
+    column ((uint8_t*)"timed", NUMWIDTH, 0);
+    column ((uint8_t*)"avg cyc", NUMWIDTH, 0);
+    column ((uint8_t*)"max cyc", NUMWIDTH, 0);
+    ece391_fdputs (1, (uint8_t*)"\n");
+    each_line (buf, show_call);
+
+    if (-1 == slurp ((uint8_t*)"irqstats", buf))
+        return 2;
+    ece391_fdputs (1, (uint8_t*)"\n vec ");
+    column ((uint8_t*)"source", NAMEWIDTH, 1);
+    column ((uint8_t*)"count", NUMWIDTH - 1, 0);
+    column ((uint8_t*)"per sec", NUMWIDTH - 1, 0);
+    column ((uint8_t*)"avg cyc", NUMWIDTH - 1, 0);
+    column ((uint8_t*)"min cyc", NUMWIDTH - 1, 0);
+    column ((uint8_t*)"max cyc", NUMWIDTH - 1, 0);
+    column ((uint8_t*)"cpu", 8, 0);
+    column ((uint8_t*)"switched", NUMWIDTH - 1, 0);
+    ece391_fdputs (1, (uint8_t*)"\n");
+    each_line (buf, show_irq);
+
+    return 0;
+}
@@ -0,0 +1,57 @@
+#include <stdint.h>
+
+#include "ece391support.h"
+#include "ece391syscall.h"
+
+#define BUFSIZE 16
+#define ITERATIONS 10000
+
+/* low half of the time-stamp counter; the loops below stay well under 2^32 cycles */
+static uint32_t rdtsc_low ()
+{
+    uint32_t lo;
+    asm volatile ("rdtsc" : "=a"(lo) : : "edx");
+    return lo;
+}
+
+static void report (const uint8_t* what, uint32_t cycles)
+{
+    uint8_t buf[BUFSIZE];
+
+    ece391_fdputs (1, what);
+    ece391_itoa (cycles / ITERATIONS, buf, 10);
+    ece391_fdputs (1, buf);
+    ece391_fdputs (1, (uint8_t*)" cycles/call\n");
+}
+
+int main ()
+{
+    uint32_t i, start;
+
+    if (!ece391_sysenter)
+        ece391_fdputs (1, (uint8_t*)"no SYSENTER on this CPU, every call below uses int 0x80\n");
+
+    /* set_handler does nothing but return -1: pure entry & exit cost */
+    start = rdtsc_low ();
+    for (i = 0; i < ITERATIONS; i++)
+        ece391_set_handler (0, 0);
+    report ((uint8_t*)"null call, sysenter: ", rdtsc_low () - start);
+
+    start = rdtsc_low ();
+    for (i = 0; i < ITERATIONS; i++)
+        ece391_int80_set_handler (0, 0);
+    report ((uint8_t*)"null call, int 0x80: ", rdtsc_low () - start);
+
+    /* an empty write also goes through the fd checks & the terminal driver */
+    start = rdtsc_low ();
+    for (i = 0; i < ITERATIONS; i++)
+        ece391_write (1, "", 0);
+    report ((uint8_t*)"empty write, sysenter: ", rdtsc_low () - start);
+
+    start = rdtsc_low ();
+    for (i = 0; i < ITERATIONS; i++)
+        ece391_int80_write (1, "", 0);
+    report ((uint8_t*)"empty write, int 0x80: ", rdtsc_low () - start);
+
+    return 0;
+}
@@ -21,6 +21,55 @@ extern int32_t ece391_getargs (uint8_t* buf, int32_t nbytes);
 extern int32_t ece391_vidmap (uint8_t** screen_start);
 extern int32_t ece391_set_handler (int32_t signum, void* handler);
 extern int32_t ece391_sigreturn (void);
+extern int32_t ece391_ioctl (int32_t fd, int32_t cmd, void* arg);
+
+/* vectored I/O: up to IOV_MAX buffers per call, read or written in order */
+#define IOV_MAX 16
+typedef struct iovec {
+	void* base;
+	int32_t len;
+} iovec_t;
+extern int32_t ece391_readv (int32_t fd, const iovec_t* iov, int32_t iovcnt);
+extern int32_t ece391_writev (int32_t fd, const iovec_t* iov, int32_t iovcnt);
+
+/*
+ * Submission ring: queue entries at sqe[tail % IO_RING_SIZE] and bump tail,
+ * then one ece391_io_enter runs them all in order, fills in each result and
+ * moves head up to tail.  It returns how many entries ran.
+ */
+#define IO_RING_SIZE 32
+#define IO_OP_NOP   0
+#define IO_OP_READ  1
+#define IO_OP_WRITE 2
+typedef struct io_sqe {
+	int32_t op;
+	int32_t fd;
+	void* buf;
+	int32_t len;
+	int32_t result;
+} io_sqe_t;
+typedef struct io_ring {
+	uint32_t head;
+	uint32_t tail;
+	io_sqe_t sqe[IO_RING_SIZE];
+} io_ring_t;
+extern int32_t ece391_io_enter (io_ring_t* ring);
+
+/* 1 if the calls above go in through SYSENTER, 0 if the CPU lacks it and
+   they fall back to int $0x80 */
+extern int32_t ece391_sysenter;
+
+/* the same calls through int $0x80 instead of SYSENTER (to compare the two) */
+extern int32_t ece391_int80_write (int32_t fd, const void* buf, int32_t nbytes);
+extern int32_t ece391_int80_set_handler (int32_t signum, void* handler);
+
+/* ece391_ioctl on an rtc: set the rate (0 keeps it) & read the tick counters at once */
+#define RTC_IOC_RATE_TICKS 1
+typedef struct rtc_ioc {
+	int32_t freq;
+	uint32_t ticks;
+	uint32_t pending;
+} rtc_ioc_t;
 
 enum signums {
 	DIV_ZERO = 0,